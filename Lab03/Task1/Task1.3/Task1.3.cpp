@@ -4,6 +4,10 @@
 using namespace std;
 
 #include <vector>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <unordered_map>
 cv::Mat image;
 vector<cv::Point> contour;
 
@@ -59,6 +63,238 @@ void findStartPoint(int x, int y) {
     start_x = x; start_y = y;
 }
 
+// ---------------------------------------------------------------------------
+// Whole-image contour extraction.
+//
+// Borders are traced on the crack lattice: every step runs along the edge between a border-colored
+// pixel and any other pixel, from one pixel corner to the next, with the border pixels on the right.
+// A step is one of 4 Freeman directions (0 E, 1 S, 2 W, 3 N, y down) and is stored in 2 bits.
+// Outer borders run clockwise (positive area), holes counterclockwise (negative area).
+// Diagonal pixels are joined (8-connectivity), like the click tracer above.
+//
+// The image is split into horizontal strips traced in parallel; borders crossing a strip seam come
+// out as fragments that are stitched into closed contours afterwards.
+// ---------------------------------------------------------------------------
+
+struct ChainContour
+{
+    cv::Point start;            // pixel corner where the chain starts
+    vector<uint8_t> codes;      // 2-bit Freeman codes, 4 per byte, first step in the low bits
+    int length = 0;             // number of steps
+    long long area = 0;         // signed area enclosed, in pixels
+    bool hole = false;
+
+    int code(int i) const { return (codes[i >> 2] >> ((i & 3) * 2)) & 3; }
+};
+
+namespace chain
+{
+    const int cdx[4] = { 1, 0, -1, 0 };
+    const int cdy[4] = { 0, 1, 0, -1 };
+
+    struct Fragment
+    {
+        int64_t first = -1, next = -1;  // edge ids of the first step and of the step after the last one
+        cv::Point start;
+        vector<uint8_t> steps;
+        long long area2 = 0;            // twice the signed area (shoelace sum)
+        bool closed = false;
+    };
+
+    // Binary mask of the border color with a 1 pixel zero frame, so corner probes need no bounds checks.
+    struct Mask
+    {
+        int w, h, stride;
+        vector<uint8_t> bits;
+
+        bool at(int x, int y) const { return bits[(size_t)(y + 1) * stride + x + 1] != 0; }
+    };
+
+    template <class Body>
+    void runStrips(int strips, const Body& body)
+    {
+        vector<std::thread> workers;
+        for (int s = 1; s < strips; ++s) workers.emplace_back([&body, s]() { body(s); });
+        body(0);
+        for (auto& t : workers) t.join();
+    }
+
+    // Edge ids: 2 * (row * (w + 1) + col) + (0 horizontal, 1 vertical). A horizontal edge lies on corner
+    // row `row` above pixel column `col`, a vertical one on corner column `col` beside pixel row `row`.
+    inline int64_t edgeId(int w, int cx, int cy, int dir)
+    {
+        switch (dir)
+        {
+        case 0: return 2 * ((int64_t)cy * (w + 1) + cx);
+        case 2: return 2 * ((int64_t)cy * (w + 1) + cx - 1);
+        case 1: return 2 * ((int64_t)cy * (w + 1) + cx) + 1;
+        default: return 2 * ((int64_t)(cy - 1) * (w + 1) + cx) + 1;
+        }
+    }
+
+    inline int edgeRow(int w, int64_t id) { return (int)((id >> 1) / (w + 1)); }
+
+    // Direction of the step leaving corner (cx, cy) after arriving with direction `in`.
+    inline int nextDir(const Mask& m, int cx, int cy, int in)
+    {
+        bool tl = m.at(cx - 1, cy - 1), tr = m.at(cx, cy - 1);
+        bool bl = m.at(cx - 1, cy), br = m.at(cx, cy);
+        int left = (in + 3) & 3;
+        bool can[4] = { br && !tr, bl && !br, tl && !bl, tr && !tl };
+        if (can[left]) return left;  // saddle: turn towards the diagonal pixel
+        if (can[in]) return in;
+        return (in + 1) & 3;
+    }
+
+    // Traces every edge owned by pixel rows [y0, y1) (plus corner row h for the last strip).
+    void traceStrip(const Mask& m, int y0, int y1, vector<uint8_t>& visited, vector<Fragment>& out)
+    {
+        const int w = m.w, h = m.h;
+        int rowEnd = y1 == h ? h + 1 : y1;
+        auto owned = [&](int64_t id) {
+            int r = edgeRow(w, id);
+            return r >= y0 && r < rowEnd;
+        };
+
+        auto trace = [&](int cx, int cy, int dir) {
+            Fragment f;
+            f.start = cv::Point(cx, cy);
+            f.first = edgeId(w, cx, cy, dir);
+            int64_t id = f.first;
+            while (true)
+            {
+                visited[id >> 1] |= (uint8_t)(1 << (id & 1));
+                f.steps.push_back((uint8_t)dir);
+                f.area2 += (long long)cx * cdy[dir] - (long long)cdx[dir] * cy;
+                cx += cdx[dir];
+                cy += cdy[dir];
+                dir = nextDir(m, cx, cy, dir);
+                id = edgeId(w, cx, cy, dir);
+                if (id == f.first)
+                {
+                    f.closed = true;
+                    break;
+                }
+                if (!owned(id) || (visited[id >> 1] >> (id & 1) & 1))
+                {
+                    f.next = id;
+                    break;
+                }
+            }
+            out.push_back(std::move(f));
+        };
+
+        for (int r = y0; r < rowEnd; ++r)
+        {
+            const uint8_t* up = &m.bits[(size_t)r * m.stride + 1];
+            const uint8_t* cur = up + m.stride;
+            const uint8_t* seen = &visited[(size_t)r * (w + 1)];
+            for (int x = 0; x <= w; ++x)
+            {
+                if (x < w && up[x] != cur[x] && !(seen[x] & 1))
+                {
+                    if (cur[x]) trace(x, r, 0);
+                    else trace(x + 1, r, 2);
+                }
+                if (r < h && cur[x - 1] != cur[x] && !(seen[x] & 2))
+                {
+                    if (cur[x - 1]) trace(x, r, 1);
+                    else trace(x, r + 1, 3);
+                }
+            }
+        }
+    }
+
+    ChainContour pack(const cv::Point& start, const vector<const Fragment*>& parts)
+    {
+        ChainContour c;
+        c.start = start;
+        for (const Fragment* f : parts)
+        {
+            c.codes.resize((c.length + f->steps.size() + 3) / 4);
+            for (uint8_t d : f->steps)
+            {
+                c.codes[c.length >> 2] |= (uint8_t)(d << ((c.length & 3) * 2));
+                c.length++;
+            }
+            c.area += f->area2;
+        }
+        c.area /= 2;
+        c.hole = c.area < 0;
+        return c;
+    }
+}
+
+vector<ChainContour> extractContours(const cv::Mat& img, const cv::Vec3b& color, int threads = 0)
+{
+    using namespace chain;
+    vector<ChainContour> result;
+    const int w = img.cols, h = img.rows;
+    if (w == 0 || h == 0) return result;
+
+    if (threads <= 0) threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    const int strips = std::max(1, std::min(threads, h / 32));
+    auto stripBegin = [&](int s) { return (int)((long long)h * s / strips); };
+
+    Mask m{ w, h, w + 2, vector<uint8_t>((size_t)(w + 2) * (h + 2), 0) };
+    runStrips(strips, [&](int s) {
+        for (int y = stripBegin(s); y < stripBegin(s + 1); ++y)
+        {
+            const cv::Vec3b* row = img.ptr<cv::Vec3b>(y);
+            uint8_t* dst = &m.bits[(size_t)(y + 1) * m.stride + 1];
+            for (int x = 0; x < w; ++x) dst[x] = row[x] == color;
+        }
+    });
+
+    vector<uint8_t> visited((size_t)(w + 1) * (h + 1), 0);
+    vector<vector<Fragment>> parts(strips);
+    runStrips(strips, [&](int s) { traceStrip(m, stripBegin(s), stripBegin(s + 1), visited, parts[s]); });
+
+    // Stitch fragments that continue in another strip (or at another fragment of the same strip).
+    std::unordered_map<int64_t, const Fragment*> byFirst;
+    for (const auto& strip : parts)
+        for (const auto& f : strip)
+        {
+            if (f.closed) result.push_back(pack(f.start, { &f }));
+            else byFirst[f.first] = &f;
+        }
+    std::unordered_map<int64_t, bool> used;
+    for (const auto& strip : parts)
+        for (const auto& f : strip)
+        {
+            if (f.closed || used[f.first]) continue;
+            vector<const Fragment*> loop;
+            const Fragment* cur = &f;
+            do
+            {
+                used[cur->first] = true;
+                loop.push_back(cur);
+                cur = byFirst.at(cur->next);
+            } while (cur != &f);
+            result.push_back(pack(f.start, loop));
+        }
+    return result;
+}
+
+// Paints the border pixel on the right of every step: red for outer borders, green for holes.
+void drawContours(cv::Mat& dst, const vector<ChainContour>& contours)
+{
+    const int px[4] = { 0, -1, -1, 0 };
+    const int py[4] = { 0, 0, -1, -1 };
+    for (const ChainContour& c : contours)
+    {
+        cv::Vec3b color = c.hole ? cv::Vec3b(0, 255, 0) : red;
+        int x = c.start.x, y = c.start.y;
+        for (int i = 0; i < c.length; ++i)
+        {
+            int d = c.code(i);
+            dst.ptr<cv::Vec3b>(y + py[d])[x + px[d]] = color;
+            x += chain::cdx[d];
+            y += chain::cdy[d];
+        }
+    }
+}
+
 void mouseCallback(int event, int x, int y, int flags, void* userdata) {
     if (event == cv::EVENT_LBUTTONDOWN) {
         // x - col; y - row
@@ -84,9 +320,31 @@ int main()
     cout << image.size << endl;
     imshow(windowName, image);
 
-    
-    
+    // c - extract and show all borders of the image, Esc - quit
+    while (true)
+    {
+        int key = cv::waitKey(0);
+        if (key == 27 || key == -1) break;
+        if (key == 'c')
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            vector<ChainContour> contours = extractContours(image, borderColor);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
 
-    cv::waitKey(0);
+            size_t holes = 0, steps = 0, bytes = 0;
+            for (const ChainContour& c : contours)
+            {
+                holes += c.hole;
+                steps += c.length;
+                bytes += c.codes.size();
+            }
+            cout << contours.size() << " contours (" << holes << " holes), " << steps << " steps in "
+                 << bytes << " bytes, " << ms << " ms" << endl;
+
+            cv::Mat view = image.clone();
+            drawContours(view, contours);
+            imshow(windowName, view);
+        }
+    }
     return 0;
 }
\ No newline at end of file
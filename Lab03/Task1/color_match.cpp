@@ -0,0 +1,166 @@
+//
+// Color tolerance matching for the paint fills, with a vectorized run search.
+//
+
+#include "color_match.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define LAB3_SSSE3 1
+#define LAB3_SSSE3_TARGET __attribute__((target("ssse3")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define LAB3_SSSE3 1
+#define LAB3_SSSE3_TARGET
+#else
+#define LAB3_SSSE3 0
+#endif
+
+#if LAB3_SSSE3
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace lab3task1 {
+    namespace {
+        int scalar_run_right(const cv::Vec3b *row, int x, int end, const cv::Vec3b &ref, const ColorTolerance &t) {
+            while (x < end && color_matches(row[x], ref, t)) x++;
+            return x;
+        }
+
+        int scalar_run_left(const cv::Vec3b *row, int x, int begin, const cv::Vec3b &ref, const ColorTolerance &t) {
+            while (x >= begin && color_matches(row[x], ref, t)) x--;
+            return x + 1;
+        }
+
+#if LAB3_SSSE3
+        inline int lowest_bit(unsigned v) {
+#ifdef _MSC_VER
+            unsigned long i;
+            _BitScanForward(&i, v);
+            return (int) i;
+#else
+            return __builtin_ctz(v);
+#endif
+        }
+
+        inline int highest_bit(unsigned v) {
+#ifdef _MSC_VER
+            unsigned long i;
+            _BitScanReverse(&i, v);
+            return (int) i;
+#else
+            return 31 - __builtin_clz(v);
+#endif
+        }
+
+        // Reference color and threshold broadcast once per run search.
+        struct MatchSimd {
+            __m128i ref_b, ref_g, ref_r, tol8, tol_sq;
+            bool euclidean;
+        };
+
+        LAB3_SSSE3_TARGET MatchSimd make_match_simd(const cv::Vec3b &ref, const ColorTolerance &t) {
+            int tol = std::clamp(t.tolerance, 0, 255);
+            return {_mm_set1_epi8((char) ref[0]), _mm_set1_epi8((char) ref[1]), _mm_set1_epi8((char) ref[2]),
+                    _mm_set1_epi8((char) (uchar) tol), _mm_set1_epi32(t.tolerance * t.tolerance),
+                    t.metric == ColorMetric::EUCLIDEAN};
+        }
+
+        // Bit i is set when pixel i of the 16 BGR pixels at p matches. The 48 bytes are split into
+        // B, G and R planes with pshufb; per-channel deltas must be <= tol either way (for the
+        // Euclidean metric it is a necessary condition), the exact squared distance follows in
+        // 32-bit lanes via pmaddwd.
+        LAB3_SSSE3_TARGET unsigned match_mask16(const uchar *p, const MatchSimd &m) {
+            const __m128i a = _mm_loadu_si128((const __m128i *) p);
+            const __m128i b = _mm_loadu_si128((const __m128i *) (p + 16));
+            const __m128i c = _mm_loadu_si128((const __m128i *) (p + 32));
+
+            const __m128i b0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+            const __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+            const __m128i b2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+            const __m128i g0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+            const __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+            const __m128i g2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+            const __m128i r0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+            const __m128i r1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+            const __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+
+            __m128i pb = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, b0), _mm_shuffle_epi8(b, b1)),
+                                      _mm_shuffle_epi8(c, b2));
+            __m128i pg = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, g0), _mm_shuffle_epi8(b, g1)),
+                                      _mm_shuffle_epi8(c, g2));
+            __m128i pr = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, r0), _mm_shuffle_epi8(b, r1)),
+                                      _mm_shuffle_epi8(c, r2));
+
+            __m128i db = _mm_or_si128(_mm_subs_epu8(pb, m.ref_b), _mm_subs_epu8(m.ref_b, pb));
+            __m128i dg = _mm_or_si128(_mm_subs_epu8(pg, m.ref_g), _mm_subs_epu8(m.ref_g, pg));
+            __m128i dr = _mm_or_si128(_mm_subs_epu8(pr, m.ref_r), _mm_subs_epu8(m.ref_r, pr));
+
+            __m128i dmax = _mm_max_epu8(db, _mm_max_epu8(dg, dr));
+            unsigned mask = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(dmax, m.tol8), m.tol8));
+            if (!m.euclidean || mask == 0) return mask;
+
+            const __m128i zero = _mm_setzero_si128();
+            __m128i far16[2];
+            for (int half = 0; half < 2; ++half) {
+                __m128i b16 = half ? _mm_unpackhi_epi8(db, zero) : _mm_unpacklo_epi8(db, zero);
+                __m128i g16 = half ? _mm_unpackhi_epi8(dg, zero) : _mm_unpacklo_epi8(dg, zero);
+                __m128i r16 = half ? _mm_unpackhi_epi8(dr, zero) : _mm_unpacklo_epi8(dr, zero);
+                __m128i bg_lo = _mm_unpacklo_epi16(b16, g16), bg_hi = _mm_unpackhi_epi16(b16, g16);
+                __m128i r_lo = _mm_unpacklo_epi16(r16, zero), r_hi = _mm_unpackhi_epi16(r16, zero);
+                __m128i d_lo = _mm_add_epi32(_mm_madd_epi16(bg_lo, bg_lo), _mm_madd_epi16(r_lo, r_lo));
+                __m128i d_hi = _mm_add_epi32(_mm_madd_epi16(bg_hi, bg_hi), _mm_madd_epi16(r_hi, r_hi));
+                far16[half] = _mm_packs_epi32(_mm_cmpgt_epi32(d_lo, m.tol_sq), _mm_cmpgt_epi32(d_hi, m.tol_sq));
+            }
+            unsigned far = (unsigned) _mm_movemask_epi8(_mm_packs_epi16(far16[0], far16[1]));
+            return mask & ~far;
+        }
+
+        LAB3_SSSE3_TARGET int simd_run_right(const cv::Vec3b *row, int x, int end, const cv::Vec3b &ref,
+                                             const ColorTolerance &t) {
+            MatchSimd m = make_match_simd(ref, t);
+            while (x + 16 <= end) {
+                unsigned mask = match_mask16((const uchar *) (row + x), m);
+                if (mask != 0xFFFFu) return x + lowest_bit(~mask & 0xFFFFu);
+                x += 16;
+            }
+            return scalar_run_right(row, x, end, ref, t);
+        }
+
+        LAB3_SSSE3_TARGET int simd_run_left(const cv::Vec3b *row, int x, int begin, const cv::Vec3b &ref,
+                                            const ColorTolerance &t) {
+            MatchSimd m = make_match_simd(ref, t);
+            while (x - 15 >= begin) {
+                unsigned mask = match_mask16((const uchar *) (row + x - 15), m);
+                if (mask != 0xFFFFu) return x - 15 + highest_bit(~mask & 0xFFFFu) + 1;
+                x -= 16;
+            }
+            return scalar_run_left(row, x, begin, ref, t);
+        }
+#endif
+    }
+
+    bool color_match_simd() {
+#if LAB3_SSSE3 && !defined(_MSC_VER)
+        static const bool supported = __builtin_cpu_supports("ssse3");
+        return supported;
+#else
+        return LAB3_SSSE3 != 0;
+#endif
+    }
+
+    int match_run_right(const cv::Vec3b *row, int x, int end, const cv::Vec3b &ref, const ColorTolerance &t) {
+#if LAB3_SSSE3
+        if (color_match_simd()) return simd_run_right(row, x, end, ref, t);
+#endif
+        return scalar_run_right(row, x, end, ref, t);
+    }
+
+    int match_run_left(const cv::Vec3b *row, int x, int begin, const cv::Vec3b &ref, const ColorTolerance &t) {
+#if LAB3_SSSE3
+        if (color_match_simd()) return simd_run_left(row, x, begin, ref, t);
+#endif
+        return scalar_run_left(row, x, begin, ref, t);
+    }
+}
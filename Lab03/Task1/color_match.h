@@ -0,0 +1,41 @@
+//
+// Color tolerance matching for the paint fills, with a vectorized run search.
+//
+
+#ifndef CS332_LAB3_COLOR_MATCH_H
+#define CS332_LAB3_COLOR_MATCH_H
+
+#include "../../provider.h"
+
+namespace lab3task1 {
+    enum class ColorMetric {
+        PER_CHANNEL,
+        EUCLIDEAN
+    };
+
+    struct ColorTolerance {
+        ColorMetric metric = ColorMetric::PER_CHANNEL;
+        int tolerance = 0;  // max channel delta (PER_CHANNEL) or max RGB distance (EUCLIDEAN)
+    };
+
+    inline bool color_matches(const cv::Vec3b &c, const cv::Vec3b &ref, const ColorTolerance &t) {
+        int db = std::abs(c[0] - ref[0]);
+        int dg = std::abs(c[1] - ref[1]);
+        int dr = std::abs(c[2] - ref[2]);
+        if (t.metric == ColorMetric::PER_CHANNEL) {
+            return std::max(db, std::max(dg, dr)) <= t.tolerance;
+        }
+        return db * db + dg * dg + dr * dr <= t.tolerance * t.tolerance;
+    }
+
+    // First x' in [x, end) whose pixel does not match ref, or end.
+    int match_run_right(const cv::Vec3b *row, int x, int end, const cv::Vec3b &ref, const ColorTolerance &t);
+
+    // Leftmost x' in [begin, x] such that every pixel of [x', x] matches ref (x + 1 if row[x] does not).
+    int match_run_left(const cv::Vec3b *row, int x, int begin, const cv::Vec3b &ref, const ColorTolerance &t);
+
+    // True when the runtime CPU takes the 16-pixel SSSE3 path.
+    bool color_match_simd();
+}
+
+#endif //CS332_LAB3_COLOR_MATCH_H
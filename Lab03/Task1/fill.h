@@ -0,0 +1,95 @@
+//
+// Iterative scanline flood fill shared by the paint tools.
+//
+
+#ifndef CS332_LAB3_FILL_H
+#define CS332_LAB3_FILL_H
+
+#include <vector>
+
+namespace lab3task1 {
+    struct FillSpan {
+        int y, x1, x2, dy;
+    };
+
+    struct FillRun {
+        int y, x1, x2;
+    };
+
+    // Span-stack flood fill (Heckbert / Smith): only span seeds go on the heap-allocated stack,
+    // each pixel is tested a bounded number of times and there is no recursion.
+    //
+    //   inside(x, y)             - pixel belongs to the region and has not been painted yet
+    //   run_right(x, y)          - for an inside pixel: first x' > x that is not inside (at most width)
+    //   run_left(x, y)           - for an inside pixel: leftmost x' <= x with [x', x] inside
+    //   paint(y, x1, x2)         - paint [x1, x2] of row y; afterwards inside() must be false there
+    //   progress(spans)          - called after every popped seed, e.g. for animation
+    //
+    // x/y ranges are [0, width) and [top, height). The run callbacks let callers scan whole runs
+    // at once (SIMD, memchr) instead of testing pixel by pixel.
+    template<class Inside, class RunRight, class RunLeft, class Paint, class Progress>
+    void span_fill_runs(int x, int y, int top, int width, int height, Inside &&inside, RunRight &&run_right,
+                        RunLeft &&run_left, Paint &&paint, Progress &&progress) {
+        auto in = [&](int px, int py) {
+            return px >= 0 && px < width && py >= top && py < height && inside(px, py);
+        };
+        if (!in(x, y)) return;
+
+        std::vector<FillSpan> stack;
+        stack.push_back({y, x, x, 1});
+        stack.push_back({y - 1, x, x, -1});
+        long long popped = 0;
+
+        while (!stack.empty()) {
+            FillSpan s = stack.back();
+            stack.pop_back();
+            if (s.y < top || s.y >= height) continue;
+
+            int x1 = s.x1, x2 = s.x2, cy = s.y, dy = s.dy;
+            int cx = x1;
+            if (in(cx, cy)) {
+                cx = run_left(x1, cy);
+                if (cx < x1) {
+                    paint(cy, cx, x1 - 1);
+                    stack.push_back({cy - dy, cx, x1 - 1, -dy});
+                }
+            }
+            while (x1 <= x2) {
+                int run = x1;
+                if (in(x1, cy)) {
+                    x1 = run_right(x1, cy);
+                    paint(cy, run, x1 - 1);
+                }
+                if (x1 > cx) stack.push_back({cy + dy, cx, x1 - 1, dy});
+                if (x1 - 1 > x2) stack.push_back({cy - dy, x2 + 1, x1 - 1, -dy});
+                x1++;
+                while (x1 < x2 && !in(x1, cy)) x1++;
+                cx = x1;
+            }
+            progress(++popped);
+        }
+    }
+
+    template<class Inside, class Paint, class Progress>
+    void span_fill(int x, int y, int top, int width, int height, Inside &&inside, Paint &&paint,
+                   Progress &&progress) {
+        auto in = [&](int px, int py) { return px >= 0 && px < width && inside(px, py); };
+        span_fill_runs(x, y, top, width, height, inside,
+                       [&](int px, int py) {
+                           while (in(px, py)) px++;
+                           return px;
+                       },
+                       [&](int px, int py) {
+                           while (in(px - 1, py)) px--;
+                           return px;
+                       },
+                       paint, progress);
+    }
+
+    template<class Inside, class Paint>
+    void span_fill(int x, int y, int top, int width, int height, Inside &&inside, Paint &&paint) {
+        span_fill(x, y, top, width, height, inside, paint, [](long long) {});
+    }
+}
+
+#endif //CS332_LAB3_FILL_H
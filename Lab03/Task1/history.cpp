@@ -0,0 +1,118 @@
+//
+// Undo/redo history of the paint canvas with tile-level copy-on-write snapshots.
+//
+
+#include "history.h"
+
+#include <cstring>
+
+namespace lab3task1 {
+    CanvasHistory::CanvasHistory(size_t budget_bytes, int tile_size) : budget(budget_bytes),
+                                                                       tile(std::max(8, tile_size)) {}
+
+    void CanvasHistory::reset(const cv::Mat &canvas, const cv::Rect &area) {
+        this->area = area & cv::Rect(0, 0, canvas.cols, canvas.rows);
+        tiles_x = (this->area.width + tile - 1) / tile;
+        tiles_y = (this->area.height + tile - 1) / tile;
+        steps.clear();
+        cursor = 0;
+        used_bytes = 0;
+
+        current.assign((size_t) tiles_x * tiles_y, nullptr);
+        for (int i = 0; i != (int) current.size(); ++i) {
+            current[i] = std::make_shared<const cv::Mat>(canvas(tile_rect(i)).clone());
+        }
+    }
+
+    cv::Rect CanvasHistory::tile_rect(int index) const {
+        int tx = index % tiles_x, ty = index / tiles_x;
+        cv::Rect r(area.x + tx * tile, area.y + ty * tile, tile, tile);
+        return r & area;
+    }
+
+    bool CanvasHistory::commit(const cv::Mat &canvas, const cv::Rect &dirty) {
+        if (current.empty()) {
+            return false;
+        }
+        cv::Rect check = dirty.area() > 0 ? (dirty & area) : area;
+        if (check.area() <= 0) {
+            return false;
+        }
+
+        int tx0 = (check.x - area.x) / tile, tx1 = (check.x + check.width - 1 - area.x) / tile;
+        int ty0 = (check.y - area.y) / tile, ty1 = (check.y + check.height - 1 - area.y) / tile;
+
+        Step step;
+        for (int ty = ty0; ty <= ty1; ++ty) {
+            for (int tx = tx0; tx <= tx1; ++tx) {
+                int index = ty * tiles_x + tx;
+                cv::Rect r = tile_rect(index);
+                const cv::Mat &old = *current[index];
+                size_t row_bytes = (size_t) r.width * canvas.elemSize();
+                bool changed = false;
+                for (int y = 0; y < r.height && !changed; ++y) {
+                    changed = std::memcmp(canvas.ptr(r.y + y) + r.x * canvas.elemSize(), old.ptr(y), row_bytes) != 0;
+                }
+                if (!changed) {
+                    continue;
+                }
+                Tile after = std::make_shared<const cv::Mat>(canvas(r).clone());
+                step.bytes += row_bytes * r.height;
+                step.changes.push_back({index, current[index], after});
+                current[index] = after;
+            }
+        }
+        if (step.changes.empty()) {
+            return false;
+        }
+
+        // A new step discards everything that could be redone.
+        while (steps.size() > cursor) {
+            used_bytes -= steps.back().bytes;
+            steps.pop_back();
+        }
+        used_bytes += step.bytes;
+        steps.push_back(std::move(step));
+        cursor = steps.size();
+        trim();
+        return true;
+    }
+
+    void CanvasHistory::apply(cv::Mat &canvas, const Step &step, bool forward) {
+        for (const auto &change: step.changes) {
+            const Tile &t = forward ? change.after : change.before;
+            t->copyTo(canvas(tile_rect(change.index)));
+            current[change.index] = t;
+        }
+    }
+
+    bool CanvasHistory::undo(cv::Mat &canvas) {
+        if (cursor == 0) {
+            return false;
+        }
+        apply(canvas, steps[--cursor], false);
+        return true;
+    }
+
+    bool CanvasHistory::redo(cv::Mat &canvas) {
+        if (cursor == steps.size()) {
+            return false;
+        }
+        apply(canvas, steps[cursor++], true);
+        return true;
+    }
+
+    void CanvasHistory::set_budget(size_t bytes) {
+        budget = bytes;
+        trim();
+    }
+
+    void CanvasHistory::trim() {
+        // The newest step always stays, even if it alone is over budget.
+        while (used_bytes > budget && steps.size() > 1 && cursor > 0) {
+            used_bytes -= steps.front().bytes;
+            steps.pop_front();
+            cursor--;
+        }
+    }
+}
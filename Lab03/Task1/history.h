@@ -0,0 +1,72 @@
+//
+// Undo/redo history of the paint canvas with tile-level copy-on-write snapshots.
+//
+
+#ifndef CS332_LAB3_HISTORY_H
+#define CS332_LAB3_HISTORY_H
+
+#include <deque>
+#include <memory>
+
+#include "../../provider.h"
+
+namespace lab3task1 {
+    // The tracked area is split into square tiles. The current state is a table of immutable tile
+    // snapshots; an operation replaces only the tiles it changed, and its history entry keeps the
+    // old and new snapshot of each of them. Unchanged tiles are shared by all versions, so history
+    // memory grows with the changed area only.
+    class CanvasHistory {
+    public:
+        explicit CanvasHistory(size_t budget_bytes = size_t(256) << 20, int tile_size = 64);
+
+        // Forgets all history and takes the current content of area as the base version.
+        void reset(const cv::Mat &canvas, const cv::Rect &area);
+
+        // Records the changes made since the last commit/undo/redo as one step. Only tiles
+        // intersecting dirty are compared (the whole area by default). Returns false if nothing changed.
+        bool commit(const cv::Mat &canvas, const cv::Rect &dirty = cv::Rect());
+
+        bool undo(cv::Mat &canvas);
+
+        bool redo(cv::Mat &canvas);
+
+        // Oldest steps are dropped while the snapshots owned by the history exceed the budget.
+        void set_budget(size_t bytes);
+
+        size_t memory() const { return used_bytes; }
+
+        size_t undo_depth() const { return cursor; }
+
+        size_t redo_depth() const { return steps.size() - cursor; }
+
+    private:
+        using Tile = std::shared_ptr<const cv::Mat>;
+
+        struct TileChange {
+            int index;
+            Tile before, after;
+        };
+
+        struct Step {
+            vec<TileChange> changes;
+            size_t bytes = 0;  // size of the snapshots this step created
+        };
+
+        cv::Rect tile_rect(int index) const;
+
+        void apply(cv::Mat &canvas, const Step &step, bool forward);
+
+        void trim();
+
+        size_t budget;
+        int tile;
+        cv::Rect area;
+        int tiles_x = 0, tiles_y = 0;
+        vec<Tile> current;
+        std::deque<Step> steps;
+        size_t cursor = 0;  // steps[0, cursor) can be undone, steps[cursor, end) redone
+        size_t used_bytes = 0;
+    };
+}
+
+#endif //CS332_LAB3_HISTORY_H
@@ -0,0 +1,173 @@
+//
+// Connected-component labeling of the canvas: every 4-connected region of one exact color gets a label.
+//
+// The image is split into horizontal strips labeled in parallel with a pixel-index union-find
+// (parents always point to a smaller index, so a root is the first pixel of its region in raster order).
+// Strip seams are merged sequentially, then the roots are numbered in raster order in parallel.
+//
+
+#include "labeling.h"
+
+#include <thread>
+
+namespace lab3task1 {
+    namespace {
+        inline bool same_color(const uchar *a, const uchar *b) {
+            return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+        }
+
+        inline int find_root(const int *parent, int i) {
+            while (parent[i] != i) i = parent[i];
+            return i;
+        }
+
+        inline int find_compress(int *parent, int i) {
+            int root = find_root(parent, i);
+            while (parent[i] != root) {
+                int next = parent[i];
+                parent[i] = root;
+                i = next;
+            }
+            return root;
+        }
+
+        inline void unite(int *parent, int a, int b) {
+            a = find_compress(parent, a);
+            b = find_compress(parent, b);
+            if (a < b) parent[b] = a;
+            else if (b < a) parent[a] = b;
+        }
+
+        template<class Body>
+        void run_strips(int strips, const Body &body) {
+            vec<std::thread> workers;
+            for (int s = 1; s < strips; ++s) workers.emplace_back([&body, s]() { body(s); });
+            body(0);
+            for (auto &w: workers) w.join();
+        }
+
+        // Union of pixel (x, y) with its left and upper neighbours. The upper union is skipped when
+        // left, upper-left and upper already share the color: they are connected through the left pixel.
+        inline void link_pixel(const cv::Mat &img, int *parent, int x, int y, int i, int cols, bool with_up) {
+            const uchar *px = img.ptr<uchar>(y) + x * 3;
+            bool left = x > 0 && same_color(px, px - 3);
+            if (!with_up) {
+                parent[i] = left ? parent[i - 1] : i;
+                return;
+            }
+            const uchar *up = img.ptr<uchar>(y - 1) + x * 3;
+            bool upper = same_color(px, up);
+            parent[i] = left ? parent[i - 1] : i;
+            if (upper && !(left && same_color(up - 3, up))) {
+                unite(parent, i, i - cols);
+            }
+        }
+    }
+
+    void RegionLabels::compute(const cv::Mat &img, int top, int threads) {
+        CV_Assert(img.type() == CV_8UC3);
+        this->top = top = std::clamp(top, 0, img.rows);
+        labels = cv::Mat(img.rows, img.cols, CV_32S, cv::Scalar(-1));
+        stats.clear();
+
+        const int cols = img.cols, rows = img.rows - top;
+        if (rows <= 0 || cols <= 0) return;
+
+        if (threads <= 0) threads = (int) std::max(1u, std::thread::hardware_concurrency());
+        const int strips = std::max(1, std::min(threads, rows / 16));
+        auto strip_begin = [&](int s) { return top + (int) ((long long) rows * s / strips); };
+
+        const size_t n = (size_t) rows * cols;
+        vec<int> parent(n);
+        int *p = parent.data();
+        int *out = labels.ptr<int>(top);
+
+        // 1. Each strip labels its own rows and flattens its trees (raster order: parents are already flat).
+        run_strips(strips, [&](int s) {
+            int y0 = strip_begin(s), y1 = strip_begin(s + 1);
+            for (int y = y0; y < y1; ++y) {
+                int i = (y - top) * cols;
+                for (int x = 0; x < cols; ++x, ++i) link_pixel(img, p, x, y, i, cols, y > y0);
+            }
+            for (int i = (y0 - top) * cols, end = (y1 - top) * cols; i < end; ++i) p[i] = p[p[i]];
+        });
+
+        // 2. Merge the first row of every strip with the last row of the previous one.
+        for (int s = 1; s < strips; ++s) {
+            int y = strip_begin(s);
+            const uchar *row = img.ptr<uchar>(y), *up = img.ptr<uchar>(y - 1);
+            int i = (y - top) * cols;
+            for (int x = 0; x < cols; ++x, ++i) {
+                if (!same_color(row + x * 3, up + x * 3)) continue;
+                if (x > 0 && same_color(row + x * 3, row + x * 3 - 3) && same_color(up + x * 3 - 3, up + x * 3)) {
+                    continue;
+                }
+                unite(p, i, i - cols);
+            }
+        }
+
+        // 3. Resolve final roots, number them in raster order and relabel.
+        vec<int> root_count(strips + 1, 0);
+        run_strips(strips, [&](int s) {
+            int count = 0;
+            for (int i = (strip_begin(s) - top) * cols, end = (strip_begin(s + 1) - top) * cols; i < end; ++i) {
+                out[i] = find_root(p, i);
+                count += out[i] == i;
+            }
+            root_count[s + 1] = count;
+        });
+        for (int s = 0; s < strips; ++s) root_count[s + 1] += root_count[s];
+        run_strips(strips, [&](int s) {
+            int id = root_count[s];
+            for (int i = (strip_begin(s) - top) * cols, end = (strip_begin(s + 1) - top) * cols; i < end; ++i) {
+                if (out[i] == i) p[i] = id++;
+            }
+        });
+        run_strips(strips, [&](int s) {
+            for (int i = (strip_begin(s) - top) * cols, end = (strip_begin(s + 1) - top) * cols; i < end; ++i) {
+                out[i] = p[out[i]];
+            }
+        });
+
+        // 4. Area, bounding box and color per region.
+        stats.resize(root_count[strips]);
+        vec<cv::Vec4i> box(stats.size(), cv::Vec4i(INT_MAX, INT_MAX, -1, -1));
+        for (int y = top; y < img.rows; ++y) {
+            const int *row = labels.ptr<int>(y);
+            const cv::Vec3b *color = img.ptr<cv::Vec3b>(y);
+            for (int x = 0; x < cols; ++x) {
+                int l = row[x];
+                RegionStats &r = stats[l];
+                cv::Vec4i &b = box[l];
+                if (r.area++ == 0) {
+                    r.color = color[x];
+                    b[1] = y;
+                }
+                b[0] = std::min(b[0], x);
+                b[2] = std::max(b[2], x);
+                b[3] = y;
+            }
+        }
+        for (size_t l = 0; l < stats.size(); ++l) {
+            const cv::Vec4i &b = box[l];
+            stats[l].bbox = cv::Rect(b[0], b[1], b[2] - b[0] + 1, b[3] - b[1] + 1);
+        }
+    }
+
+    bool RegionLabels::recolor(cv::Mat &img, int label, const cv::Vec3b &new_color) {
+        bool merges = false;
+        auto touches = [&](int x, int y) {
+            return x >= 0 && x < img.cols && y >= top && y < img.rows && labels.ptr<int>(y)[x] != label &&
+                   img.ptr<cv::Vec3b>(y)[x] == new_color;
+        };
+        for_each_run(label, [&](int y, int x1, int x2) {
+            cv::Vec3b *row = img.ptr<cv::Vec3b>(y);
+            std::fill(row + x1, row + x2 + 1, new_color);
+            if (merges) return;
+            merges = touches(x1 - 1, y) || touches(x2 + 1, y);
+            for (int x = x1; x <= x2 && !merges; ++x) merges = touches(x, y - 1) || touches(x, y + 1);
+        });
+        stats[label].color = new_color;
+        return !merges;
+    }
+}
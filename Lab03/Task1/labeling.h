@@ -0,0 +1,56 @@
+//
+// Connected-component labeling of the canvas: every 4-connected region of one exact color gets a label.
+//
+
+#ifndef CS332_LAB3_LABELING_H
+#define CS332_LAB3_LABELING_H
+
+#include "../../provider.h"
+
+namespace lab3task1 {
+    struct RegionStats {
+        long long area = 0;
+        cv::Rect bbox;
+        cv::Vec3b color;
+    };
+
+    class RegionLabels {
+    public:
+        // Labels rows [top, img.rows) of a CV_8UC3 image. Rows above top get label -1.
+        // threads <= 0 uses std::thread::hardware_concurrency().
+        void compute(const cv::Mat &img, int top, int threads = 0);
+
+        bool empty() const { return labels.empty(); }
+
+        int label_at(int x, int y) const { return labels.ptr<int>(y)[x]; }
+
+        const vec<RegionStats> &regions() const { return stats; }
+
+        // Calls paint(y, x1, x2) for every run of pixels with the given label, top to bottom.
+        template<class Paint>
+        void for_each_run(int label, Paint &&paint) const {
+            const cv::Rect &box = stats[label].bbox;
+            for (int y = box.y; y < box.y + box.height; ++y) {
+                const int *row = labels.ptr<int>(y);
+                int x = box.x, end = box.x + box.width;
+                while (x < end) {
+                    while (x < end && row[x] != label) x++;
+                    int start = x;
+                    while (x < end && row[x] == label) x++;
+                    if (x > start) paint(y, start, x - 1);
+                }
+            }
+        }
+
+        // Repaints the region and keeps the labels valid if it does not touch another region of new_color;
+        // returns false (labels are stale) otherwise.
+        bool recolor(cv::Mat &img, int label, const cv::Vec3b &new_color);
+
+    private:
+        cv::Mat labels;  // CV_32S, label per pixel
+        vec<RegionStats> stats;
+        int top = 0;
+    };
+}
+
+#endif //CS332_LAB3_LABELING_H
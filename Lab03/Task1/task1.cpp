@@ -4,6 +4,8 @@
 
 #include "task1.h"
 
+#include <chrono>
+#include <cstring>
 #include <utility>
 
 void lab3task1::App::run() {
@@ -13,14 +15,33 @@ void lab3task1::App::run() {
     create_tools_panel();
     create_color_panel();
     cv::imshow("Paint", this->img);
+    history.reset(img, canvas_rect());
     load_img("/Users/kalyuzhin/Developer/CLionProjects/CS332/gats.jpeg");
 
     while (true) {
+        present();
         char key = (char) cv::waitKey(1);
         if (key == 27) {
             break;
         } else if (key == 32) {
             clear();
+        } else if (key == 'a') {
+            animate_fill = !animate_fill;
+            std::cout << "Fill animation: " << (animate_fill ? "on" : "off") << std::endl;
+        } else if (key == '+' || key == '=' || key == '-') {
+            fill_tolerance.tolerance = std::clamp(fill_tolerance.tolerance + (key == '-' ? -4 : 4), 0, 442);
+            std::cout << "Fill tolerance: " << fill_tolerance.tolerance << std::endl;
+        } else if (key == 'm') {
+            bool euclidean = fill_tolerance.metric == ColorMetric::PER_CHANNEL;
+            fill_tolerance.metric = euclidean ? ColorMetric::EUCLIDEAN : ColorMetric::PER_CHANNEL;
+            std::cout << "Fill metric: " << (euclidean ? "euclidean" : "per channel") << std::endl;
+        } else if (key == 'z' || key == 26) {
+            undo();
+        } else if (key == 'y' || key == 25) {
+            redo();
+        } else if (key == 'l') {
+            labels_dirty = true;
+            update_labels();
         }
     }
 }
@@ -40,8 +61,12 @@ void lab3task1::App::on_mouse(int event, int x, int y, int flags, void *userdata
             if (app->drawing) {
                 if (app->cur_tool == lab3task1::PEN) {
                     cv::line(app->img, app->prev_point, cv::Point(x, y), app->cur_color, app->brush_size);
+                    app->labels_dirty = true;
+                    int pad = (int) app->brush_size + 1;
+                    cv::Point a = app->prev_point;
+                    app->mark_dirty(cv::Rect(std::min(a.x, x) - pad, std::min(a.y, y) - pad,
+                                             std::abs(a.x - x) + 2 * pad + 1, std::abs(a.y - y) + 2 * pad + 1));
                     app->prev_point = cv::Point(x, y);
-                    cv::imshow("Paint", app->img);
                 }
             }
         } else if (event == cv::EVENT_LBUTTONUP) {
@@ -51,7 +76,9 @@ void lab3task1::App::on_mouse(int event, int x, int y, int flags, void *userdata
                 int radius = static_cast<int>(std::sqrt(std::pow(end_point.x - app->start_point.x, 2) +
                                                         std::pow(end_point.y - app->start_point.y, 2)));
                 cv::circle(app->img, app->start_point, radius, app->cur_color, app->brush_size);
-                cv::imshow("Paint", app->img);
+                app->labels_dirty = true;
+                int pad = radius + (int) app->brush_size + 1;
+                app->mark_dirty(cv::Rect(app->start_point.x - pad, app->start_point.y - pad, 2 * pad + 1, 2 * pad + 1));
             }
         }
     } else if (y > PANEL_HEIGHT && y < PANEL_HEIGHT + COLOR_PANEL_HEIGHT) {
@@ -61,7 +88,7 @@ void lab3task1::App::on_mouse(int event, int x, int y, int flags, void *userdata
                 if (btn.rect.contains(cv::Point(x, local_y))) {
                     app->cur_color = btn.color;
                     app->create_color_panel();
-                    cv::imshow("Paint", app->img);
+                    app->mark_dirty(cv::Rect(0, PANEL_HEIGHT, app->img.cols, COLOR_PANEL_HEIGHT));
                     break;
                 }
             }
@@ -72,7 +99,7 @@ void lab3task1::App::on_mouse(int event, int x, int y, int flags, void *userdata
                 if (btn.rect.contains(cv::Point(x, y))) {
                     app->cur_tool = btn.tool;
                     app->create_tools_panel();
-                    cv::imshow("Paint", app->img);
+                    app->mark_dirty(cv::Rect(0, 0, app->img.cols, PANEL_HEIGHT));
                     break;
                 }
             }
@@ -82,19 +109,35 @@ void lab3task1::App::on_mouse(int event, int x, int y, int flags, void *userdata
     if (event == cv::EVENT_LBUTTONDOWN) {
         if (app->cur_tool == lab3task1::FILL) {
             app->fill(x, y);
-            cv::imshow("Paint", app->img);
+            app->labels_dirty = true;
         }
         if (app->cur_tool == lab3task1::FILL_WITH_IMG) {
             app->fill_img(x, y);
-            cv::imshow("Paint", app->img);
+            app->labels_dirty = true;
+        }
+        if (app->cur_tool == lab3task1::FILL_TOLERANCE) {
+            app->fill_similar(x, y);
+            app->labels_dirty = true;
+        }
+        if (app->cur_tool == lab3task1::FILL_REGION) {
+            app->fill_region(x, y);
+        }
+        if (app->cur_tool == lab3task1::FILL_ALL) {
+            app->fill_all(x, y);
         }
     }
+
+    // Every stroke, shape or fill is finished by the time the button is released.
+    if (event == cv::EVENT_LBUTTONUP && app->dirty_rect.area() > 0) {
+        app->history.commit(app->img, app->dirty_rect);
+        app->dirty_rect = cv::Rect();
+    }
 }
 
 void lab3task1::App::create_tools_panel() {
     cv::Mat panel = cv::Mat(PANEL_HEIGHT, this->img.cols, CV_8UC3, cv::Scalar(50, 50, 50));
-    vec<Tool> tools = {PEN, CIRCLE, FILL, FILL_WITH_IMG};
-    vec<std::string> tools_names = {"Pen", "Circle", "Fill", "Fill with img"};
+    vec<Tool> tools = {PEN, CIRCLE, FILL, FILL_WITH_IMG, FILL_TOLERANCE, FILL_REGION, FILL_ALL};
+    vec<std::string> tools_names = {"Pen", "Circle", "Fill", "Fill with img", "Fill similar", "Region", "Fill all"};
     cv::Scalar text_color = cv::Scalar(255, 255, 255);
 
     this->tool_buttons.clear();
@@ -153,48 +196,30 @@ lab3task1::ColorButton::ColorButton(int x, cv::Scalar color) {
     this->color = std::move(color);
 }
 
-void lab3task1::App::fill_recursive(int x, int y, const cv::Vec3b &target_color, const cv::Vec3b &new_color) {
-    if (x < 0 || x >= img.cols || y < (PANEL_HEIGHT + COLOR_PANEL_HEIGHT) || y >= img.rows) {
+void lab3task1::App::fill_color(int x, int y, const cv::Vec3b &target_color, const cv::Vec3b &new_color) {
+    if (target_color == new_color) {
         return;
     }
 
-    cv::Vec3b cur_color = img.at<cv::Vec3b>(y, x);
+    cv::Rect painted;
+    span_fill(x, y, PANEL_HEIGHT + COLOR_PANEL_HEIGHT, img.cols, img.rows,
+              [&](int px, int py) { return img.ptr<cv::Vec3b>(py)[px] == target_color; },
+              [&](int py, int x1, int x2) {
+                  cv::Vec3b *row = img.ptr<cv::Vec3b>(py);
+                  std::fill(row + x1, row + x2 + 1, new_color);
+                  painted |= cv::Rect(x1, py, x2 - x1 + 1, 1);
+              },
+              [&](long long spans) { show_fill_progress(spans); });
+    mark_dirty(painted);
+}
 
-    if (cur_color != target_color || cur_color == new_color) {
+// Animation is only a view of the fill: every few spans the current canvas is shown.
+void lab3task1::App::show_fill_progress(long long spans) {
+    if (!animate_fill || spans % 64 != 0) {
         return;
     }
-
-    int left = x;
-    while (left >= 0) {
-        cv::Vec3b color = img.at<cv::Vec3b>(y, left);
-        if (color != target_color || color == new_color) break;
-        left--;
-    }
-    left++;
-
-    int right = x;
-    while (right < img.cols) {
-        cv::Vec3b color = img.at<cv::Vec3b>(y, right);
-        if (color != target_color || color == new_color) break;
-        right++;
-    }
-    right--;
-
-    int mod = abs(left - right) > 1000 ? 20000 : 100;
-
-    for (int i = left; i <= right; i++) {
-        img.at<cv::Vec3b>(y, i) = new_color;
-
-        if ((i - left) % mod == 0) {
-            cv::imshow("Paint", img);
-            cv::waitKey(1);
-        }
-    }
-
-    for (int i = left; i <= right; i++) {
-        fill_recursive(i, y - 1, target_color, new_color);
-        fill_recursive(i, y + 1, target_color, new_color);
-    }
+    cv::imshow("Paint", img);
+    cv::waitKey(1);
 }
 
 void lab3task1::App::fill(ll x, ll y) {
@@ -206,16 +231,18 @@ void lab3task1::App::fill(ll x, ll y) {
                 static_cast<uchar>(cur_color[2])
         );
 
-        fill_recursive(x, y, target_color, new_color);
+        fill_color(x, y, target_color, new_color);
     }
 }
 
 void lab3task1::App::clear() {
     setup();
+    history.commit(img);
 }
 
 void lab3task1::App::setup() {
     img = cv::Mat(img.size(), img.type(), cv::Scalar(255, 255, 255));
+    labels_dirty = true;
     cv::namedWindow("Paint");
     cv::setMouseCallback("Paint", on_mouse, this);
 
@@ -224,48 +251,48 @@ void lab3task1::App::setup() {
     cv::imshow("Paint", this->img);
 }
 
-void lab3task1::App::fill_recursive_img(int x, int y, const cv::Vec3b &target_color) {
-    if (x < 0 || x >= img.cols || y < (PANEL_HEIGHT + COLOR_PANEL_HEIGHT) || y >= img.rows)
-        return;
+// Copies pixels [x1, x2] of a pattern row that repeats every pattern_cols pixels, where dst[x1]
+// corresponds to pattern[src_x]. Whole runs up to the next tile boundary go out with one memcpy.
+static void copy_tiled_row(cv::Vec3b *dst, int x1, int x2, const cv::Vec3b *pattern, int pattern_cols, int src_x) {
+    while (x1 <= x2) {
+        int len = std::min(x2 - x1 + 1, pattern_cols - src_x);
+        std::memcpy(dst + x1, pattern + src_x, len * sizeof(cv::Vec3b));
+        x1 += len;
+        src_x = 0;
+    }
+}
 
-    cv::Vec3b cur_color = img.at<cv::Vec3b>(y, x);
-    if (cur_color != target_color)
+// The region is collected first (fill_runs / fill_mask), so holes and pattern pixels that happen to
+// match target_color are never revisited; then every run is blitted row by row.
+//
+// If the loaded image covers the whole region it is placed once at the region's top-left corner
+// (large-image mode); otherwise it is tiled, anchored at the click point.
+void lab3task1::App::fill_pattern(int x, int y, const cv::Vec3b &target_color) {
+    if (loaded_img.empty() || img.at<cv::Vec3b>(y, x) != target_color) {
         return;
-
-    int left = x;
-    while (left >= 0) {
-        cv::Vec3b color = img.at<cv::Vec3b>(y, left);
-        if (color != target_color) break;
-        left--;
     }
-    left++;
 
-    int right = x;
-    while (right < img.cols) {
-        cv::Vec3b color = img.at<cv::Vec3b>(y, right);
-        if (color != target_color) break;
-        right++;
+    collect_region(x, y, {ColorMetric::PER_CHANNEL, 0});
+    if (fill_runs.empty()) {
+        return;
     }
-    right--;
 
-    for (int i = left; i <= right; ++i) {
-        int img_x = i - offset_x;
-        int img_y = y - offset_y;
+    cv::Rect bounds = runs_rect();
+    bool single = loaded_img.cols >= bounds.width && loaded_img.rows >= bounds.height;
+    int anchor_x = single ? bounds.x : offset_x;
+    int anchor_y = single ? bounds.y : offset_y;
 
-        img_x = (img_x % loaded_img.cols + loaded_img.cols) % loaded_img.cols;
+    long long blitted = 0;
+    for (const auto &run: fill_runs) {
+        int img_y = run.y - anchor_y;
         img_y = (img_y % loaded_img.rows + loaded_img.rows) % loaded_img.rows;
-
-        if (img_x >= 0 && img_x < loaded_img.cols &&
-            img_y >= 0 && img_y < loaded_img.rows) {
-            cv::Vec3b pattern_color = loaded_img.at<cv::Vec3b>(img_y, img_x);
-            img.at<cv::Vec3b>(y, i) = pattern_color;
-        }
-    }
-
-    for (int i = left; i <= right; i++) {
-        fill_recursive_img(i, y - 1, target_color);
-        fill_recursive_img(i, y + 1, target_color);
+        int img_x = run.x1 - anchor_x;
+        img_x = (img_x % loaded_img.cols + loaded_img.cols) % loaded_img.cols;
+        copy_tiled_row(img.ptr<cv::Vec3b>(run.y), run.x1, run.x2, loaded_img.ptr<cv::Vec3b>(img_y),
+                       loaded_img.cols, img_x);
+        show_fill_progress(++blitted);
     }
+    mark_dirty(bounds);
 }
 
 void lab3task1::App::load_img(const string &path) {
@@ -277,6 +304,187 @@ void lab3task1::App::fill_img(ll x, ll y) {
         offset_x = x;
         offset_y = y;
         cv::Vec3b target_color = img.at<cv::Vec3b>(y, x);
-        fill_recursive_img(x, y, target_color);
+        fill_pattern(x, y, target_color);
+    }
+}
+
+// Collects the 4-connected region of pixels within tolerance of the seed color into fill_runs
+// (row spans) and fill_mask, without touching img. Runs are searched 16 pixels at a time and
+// already collected pixels are skipped with memchr over the mask row.
+void lab3task1::App::collect_region(int x, int y, const ColorTolerance &tolerance) {
+    fill_runs.clear();
+    if (fill_mask.rows != img.rows || fill_mask.cols != img.cols) {
+        fill_mask = cv::Mat(img.rows, img.cols, CV_8UC1, cv::Scalar(0));
+    } else {
+        fill_mask.setTo(cv::Scalar(0));
+    }
+    if (x < 0 || x >= img.cols || y < 0 || y >= img.rows) {
+        return;
+    }
+
+    const cv::Vec3b ref = img.ptr<cv::Vec3b>(y)[x];
+    span_fill_runs(x, y, PANEL_HEIGHT + COLOR_PANEL_HEIGHT, img.cols, img.rows,
+                   [&](int px, int py) {
+                       return !fill_mask.ptr<uchar>(py)[px] &&
+                              color_matches(img.ptr<cv::Vec3b>(py)[px], ref, tolerance);
+                   },
+                   [&](int px, int py) {
+                       const uchar *mask = fill_mask.ptr<uchar>(py);
+                       int end = match_run_right(img.ptr<cv::Vec3b>(py), px, img.cols, ref, tolerance);
+                       const void *hit = std::memchr(mask + px, 1, end - px);
+                       return hit ? (int) (static_cast<const uchar *>(hit) - mask) : end;
+                   },
+                   [&](int px, int py) {
+                       const uchar *mask = fill_mask.ptr<uchar>(py);
+                       int begin = match_run_left(img.ptr<cv::Vec3b>(py), px, 0, ref, tolerance);
+                       for (int i = px; i >= begin; --i) {
+                           if (mask[i]) return i + 1;
+                       }
+                       return begin;
+                   },
+                   [&](int py, int x1, int x2) {
+                       std::memset(fill_mask.ptr<uchar>(py) + x1, 1, x2 - x1 + 1);
+                       fill_runs.push_back({py, x1, x2});
+                   },
+                   [](long long) {});
+}
+
+// Bounding box of fill_runs, empty if there are none.
+cv::Rect lab3task1::App::runs_rect() const {
+    if (fill_runs.empty()) {
+        return {};
+    }
+    int min_x = img.cols, max_x = -1, min_y = img.rows, max_y = -1;
+    for (const auto &run: fill_runs) {
+        min_x = std::min(min_x, run.x1);
+        max_x = std::max(max_x, run.x2);
+        min_y = std::min(min_y, run.y);
+        max_y = std::max(max_y, run.y);
+    }
+    return {min_x, min_y, max_x - min_x + 1, max_y - min_y + 1};
+}
+
+void lab3task1::App::fill_similar(ll x, ll y) {
+    if (x >= 0 && x < img.cols && y >= (PANEL_HEIGHT + COLOR_PANEL_HEIGHT) && y < img.rows) {
+        cv::Vec3b new_color = cv::Vec3b(
+                static_cast<uchar>(cur_color[0]),
+                static_cast<uchar>(cur_color[1]),
+                static_cast<uchar>(cur_color[2])
+        );
+
+        collect_region((int) x, (int) y, fill_tolerance);
+        for (const auto &run: fill_runs) {
+            cv::Vec3b *row = img.ptr<cv::Vec3b>(run.y);
+            std::fill(row + run.x1, row + run.x2 + 1, new_color);
+        }
+        mark_dirty(runs_rect());
+    }
+}
+
+// Relabels the canvas only after something was drawn; region fills keep the labels valid on their own
+// as long as the recolored region does not touch another region of the new color.
+void lab3task1::App::update_labels() {
+    if (!labels_dirty && !region_labels.empty()) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    region_labels.compute(img, PANEL_HEIGHT + COLOR_PANEL_HEIGHT);
+    labels_dirty = false;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Labeled " << region_labels.regions().size() << " regions in " << ms << " ms" << std::endl;
+}
+
+void lab3task1::App::fill_region(ll x, ll y) {
+    if (x >= 0 && x < img.cols && y >= (PANEL_HEIGHT + COLOR_PANEL_HEIGHT) && y < img.rows) {
+        cv::Vec3b new_color = cv::Vec3b(
+                static_cast<uchar>(cur_color[0]),
+                static_cast<uchar>(cur_color[1]),
+                static_cast<uchar>(cur_color[2])
+        );
+
+        update_labels();
+        int label = region_labels.label_at((int) x, (int) y);
+        const RegionStats &region = region_labels.regions()[label];
+        std::cout << "Region " << label << ": area " << region.area << ", bbox " << region.bbox.width << "x"
+                  << region.bbox.height << " at (" << region.bbox.x << ", " << region.bbox.y << ")" << std::endl;
+        if (region.color != new_color) {
+            if (!region_labels.recolor(img, label, new_color)) {
+                labels_dirty = true;
+            }
+            mark_dirty(region.bbox);
+        }
+    }
+}
+
+void lab3task1::App::fill_all(ll x, ll y) {
+    if (x >= 0 && x < img.cols && y >= (PANEL_HEIGHT + COLOR_PANEL_HEIGHT) && y < img.rows) {
+        cv::Vec3b new_color = cv::Vec3b(
+                static_cast<uchar>(cur_color[0]),
+                static_cast<uchar>(cur_color[1]),
+                static_cast<uchar>(cur_color[2])
+        );
+
+        update_labels();
+        cv::Vec3b target_color = img.at<cv::Vec3b>(y, x);
+        if (target_color == new_color) {
+            return;
+        }
+
+        // Regions of one color never touch each other, so only contact with existing new_color regions
+        // invalidates the labels.
+        ll filled = 0;
+        bool valid = true;
+        for (int label = 0; label != (int) region_labels.regions().size(); ++label) {
+            if (region_labels.regions()[label].color == target_color) {
+                valid = region_labels.recolor(img, label, new_color) && valid;
+                mark_dirty(region_labels.regions()[label].bbox);
+                filled++;
+            }
+        }
+        labels_dirty = labels_dirty || !valid;
+        std::cout << "Filled " << filled << " regions" << std::endl;
+    }
+}
+
+// Area below the tool and color panels; the panels are redrawn on demand and not kept in the history.
+cv::Rect lab3task1::App::canvas_rect() const {
+    int top = PANEL_HEIGHT + COLOR_PANEL_HEIGHT;
+    return {0, top, img.cols, std::max(0, img.rows - top)};
+}
+
+void lab3task1::App::undo() {
+    if (history.undo(img)) {
+        labels_dirty = true;
+        needs_present = true;
+    }
+    std::cout << "Undo: " << history.undo_depth() << " steps back, " << history.redo_depth() << " forward, "
+              << history.memory() / 1024 << " KB" << std::endl;
+}
+
+void lab3task1::App::redo() {
+    if (history.redo(img)) {
+        labels_dirty = true;
+        needs_present = true;
+    }
+    std::cout << "Redo: " << history.undo_depth() << " steps back, " << history.redo_depth() << " forward, "
+              << history.memory() / 1024 << " KB" << std::endl;
+}
+
+// Drawing only records what changed; the window is updated once per event loop tick in present(),
+// however many mouse events arrived in between. The rectangle also narrows the next history commit.
+void lab3task1::App::mark_dirty(const cv::Rect &rect) {
+    cv::Rect r = rect & cv::Rect(0, 0, img.cols, img.rows);
+    if (r.area() <= 0) {
+        return;
+    }
+    dirty_rect = dirty_rect.area() > 0 ? (dirty_rect | r) : r;
+    needs_present = true;
+}
+
+void lab3task1::App::present() {
+    if (!needs_present) {
+        return;
     }
+    cv::imshow("Paint", img);
+    needs_present = false;
 }
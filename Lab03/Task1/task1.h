@@ -8,6 +8,10 @@
 #include <utility>
 
 #include "../../provider.h"
+#include "fill.h"
+#include "color_match.h"
+#include "labeling.h"
+#include "history.h"
 
 
 const int PANEL_HEIGHT = 80;
@@ -21,7 +25,10 @@ namespace lab3task1 {
         PEN,
         CIRCLE,
         FILL,
-        FILL_WITH_IMG
+        FILL_WITH_IMG,
+        FILL_TOLERANCE,
+        FILL_REGION,
+        FILL_ALL
     };
 
     class Button {
@@ -58,6 +65,19 @@ namespace lab3task1 {
         bool tile_mode;
         int offset_x = 0;
         int offset_y = 0;
+        bool animate_fill = false;
+
+        ColorTolerance fill_tolerance{ColorMetric::PER_CHANNEL, 24};
+        cv::Mat fill_mask;
+        vec<FillRun> fill_runs;
+
+        RegionLabels region_labels;
+        bool labels_dirty = true;
+
+        CanvasHistory history;
+
+        cv::Rect dirty_rect;
+        bool needs_present = false;
 
         vec<Button> tool_buttons;
         vec<ColorButton> color_buttons;
@@ -74,20 +94,45 @@ namespace lab3task1 {
 
         void fill(ll x, ll y);
 
-        void fill_recursive(int x, int y, const cv::Vec3b &target_color, const cv::Vec3b &new_color);
+        void fill_color(int x, int y, const cv::Vec3b &target_color, const cv::Vec3b &new_color);
+
+        void show_fill_progress(long long spans);
 
         void load_img(const string &path);
 
-        void fill_recursive_img(int x, int y, const cv::Vec3b &target_color);
+        void fill_pattern(int x, int y, const cv::Vec3b &target_color);
 
         void fill_img(ll x, ll y);
 
+        void collect_region(int x, int y, const ColorTolerance &tolerance);
+
+        cv::Rect runs_rect() const;
+
+        void fill_similar(ll x, ll y);
+
+        void update_labels();
+
+        cv::Rect canvas_rect() const;
+
+        void mark_dirty(const cv::Rect &rect);
+
+        void present();
+
+        void undo();
+
+        void redo();
+
+        void fill_region(ll x, ll y);
+
+        void fill_all(ll x, ll y);
+
 
     public:
-        App(int h, int w, ll brush_size = 3, cv::Scalar color = cv::Scalar(0, 0, 0)) : img(h, w, CV_8UC3,
-                                                                                           cv::Scalar(255, 255, 255)),
-                                                                                       brush_size(brush_size),
-                                                                                       cur_color(std::move(color)) {};
+        App(int h, int w, ll brush_size = 3, cv::Scalar color = cv::Scalar(0, 0, 0),
+            size_t history_budget = size_t(256) << 20) : img(h, w, CV_8UC3, cv::Scalar(255, 255, 255)),
+                                                         brush_size(brush_size),
+                                                         cur_color(std::move(color)),
+                                                         history(history_budget) {};
 
         void run();
     };
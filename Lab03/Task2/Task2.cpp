@@ -1,6 +1,17 @@
 #include <iostream>
 #include <opencv2/opencv.hpp>
+#include <chrono>
+#include <cstdint>
+#include <random>
 #include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LINE_DRAWER_SSE2 1
+#else
+#define LINE_DRAWER_SSE2 0
+#endif
 
 class LineDrawer {
 public:
@@ -76,13 +87,15 @@ public:
         float y = y0 + gradient;
 
         for (int x = static_cast<int>(x0) + 1; x <= static_cast<int>(x1) - 1; x++) {
+            // floor, not a cast: the weights are split around floor(y), also for y < 0.
+            int yi = static_cast<int>(std::floor(y));
             if (steep) {
-                drawPixelWu(image, static_cast<int>(y), x, 1.0f - (y - std::floor(y)), color);
-                drawPixelWu(image, static_cast<int>(y) + 1, x, y - std::floor(y), color);
+                drawPixelWu(image, yi, x, 1.0f - (y - yi), color);
+                drawPixelWu(image, yi + 1, x, y - yi, color);
             }
             else {
-                drawPixelWu(image, x, static_cast<int>(y), 1.0f - (y - std::floor(y)), color);
-                drawPixelWu(image, x, static_cast<int>(y) + 1, y - std::floor(y), color);
+                drawPixelWu(image, x, yi, 1.0f - (y - yi), color);
+                drawPixelWu(image, x, yi + 1, y - yi, color);
             }
             y += gradient;
         }
@@ -97,7 +110,379 @@ public:
         }
     }
 
+    // Batch versions: every segment is clipped to the image once, then rasterized through row pointers
+    // without per-pixel bounds checks. Segments are (x0, y0, x1, y1).
+
+    // Same pixels as drawLineBresenham for every segment.
+    static void drawLinesBresenham(cv::Mat& image, const std::vector<cv::Vec4i>& segments,
+        const cv::Vec3b& color = cv::Vec3b(255, 255, 255)) {
+        for (const cv::Vec4i& s : segments) {
+            drawClippedBresenham(image, s[0], s[1], s[2], s[3], color);
+        }
+    }
+
+    // Wu lines with 16.16 fixed-point stepping and 8-bit integer blending. Horizontal lines are blended
+    // as whole rows with SSE2, vertical lines with constant weights.
+    static void drawLinesWu(cv::Mat& image, const std::vector<cv::Vec4f>& segments,
+        const cv::Vec3b& color = cv::Vec3b(255, 255, 255)) {
+        for (const cv::Vec4f& s : segments) {
+            drawClippedWu(image, s[0], s[1], s[2], s[3], color);
+        }
+    }
+
+    // Gamma-correct Wu line: coverage is blended in linear light through sRGB<->linear lookup tables,
+    // endpoints get their fractional coverage, and all stepping is fixed point (coordinates in 1/256 px,
+    // the minor coordinate in 16.16, coverage in 0..256).
+    static void drawLineWuGamma(cv::Mat& image, float x0, float y0, float x1, float y1,
+        const cv::Vec3b& color = cv::Vec3b(255, 255, 255)) {
+        const GammaTables& lut = gammaTables();
+        uint16_t linear[3] = { lut.to_linear[color[0]], lut.to_linear[color[1]], lut.to_linear[color[2]] };
+        drawWuGamma(image, x0, y0, x1, y1, color, linear);
+    }
+
+    static void drawLinesWuGamma(cv::Mat& image, const std::vector<cv::Vec4f>& segments,
+        const cv::Vec3b& color = cv::Vec3b(255, 255, 255)) {
+        const GammaTables& lut = gammaTables();
+        uint16_t linear[3] = { lut.to_linear[color[0]], lut.to_linear[color[1]], lut.to_linear[color[2]] };
+        for (const cv::Vec4f& s : segments) {
+            drawWuGamma(image, s[0], s[1], s[2], s[3], color, linear);
+        }
+    }
+
 private:
+    // Narrows the interior columns [first, last] of a Wu line to the image. The line samples its minor
+    // coordinate as y(x) = y_at + gradient * (x - x_at), which can be up to a pixel off the geometric line,
+    // so the minor range is solved on that sampled line. One pixel of slack on each side covers rounding;
+    // the callers still check the minor coordinate of every pixel.
+    static void clipWuColumns(int& first, int& last, double x_at, double y_at, double gradient,
+        int maj_size, int min_size) {
+        first = std::max(first, 0);
+        last = std::min(last, maj_size - 1);
+        if (first > last || gradient == 0) {
+            return;
+        }
+        double xa = x_at + (-2.0 - y_at) / gradient;
+        double xb = x_at + (min_size + 1.0 - y_at) / gradient;
+        if (xa > xb) {
+            std::swap(xa, xb);
+        }
+        first = (int)std::max((double)first, std::floor(xa));
+        last = (int)std::min((double)last, std::ceil(xb));
+    }
+
+    // Bresenham step i of a line with major/minor deltas (dmaj, dmin) moves k(i) = floor((2*i*dmin + dmaj) / (2*dmaj))
+    // times along the minor axis. Clipping is done on i: the major axis gives a range directly, the minor one
+    // by inverting k(i), so the clipped line keeps exactly the pixels of the unclipped one.
+    static void drawClippedBresenham(cv::Mat& image, int x0, int y0, int x1, int y1, const cv::Vec3b& color) {
+        int dx = std::abs(x1 - x0), dy = std::abs(y1 - y0);
+        int x_step = (x0 < x1) ? 1 : -1;
+        int y_step = (y0 < y1) ? 1 : -1;
+        bool steep = dy > dx;
+
+        int maj0 = steep ? y0 : x0, min0 = steep ? x0 : y0;
+        int maj_step = steep ? y_step : x_step, min_step = steep ? x_step : y_step;
+        int maj_size = steep ? image.rows : image.cols, min_size = steep ? image.cols : image.rows;
+        long long dmaj = steep ? dy : dx, dmin = steep ? dx : dy;
+
+        auto ceil_div = [](long long a, long long b) { return a >= 0 ? (a + b - 1) / b : -((-a) / b); };
+
+        // Major axis: maj0 + i * maj_step in [0, maj_size - 1].
+        long long lo = 0, hi = dmaj;
+        if (maj_step > 0) {
+            lo = std::max(lo, (long long)-maj0);
+            hi = std::min(hi, (long long)maj_size - 1 - maj0);
+        }
+        else {
+            lo = std::max(lo, (long long)maj0 - (maj_size - 1));
+            hi = std::min(hi, (long long)maj0);
+        }
+
+        // Minor axis: k(i) in [k_lo, k_hi].
+        long long k_lo = min_step > 0 ? -min0 : min0 - (min_size - 1);
+        long long k_hi = min_step > 0 ? min_size - 1 - min0 : min0;
+        if (dmin == 0) {
+            if (k_lo > 0 || k_hi < 0) {
+                return;
+            }
+        }
+        else {
+            if (k_lo > 0) {
+                lo = std::max(lo, ceil_div(2 * dmaj * k_lo - dmaj, 2 * dmin));
+            }
+            hi = std::min(hi, ceil_div(2 * dmaj * (k_hi + 1) - dmaj, 2 * dmin) - 1);
+        }
+        if (lo > hi) {
+            return;
+        }
+
+        long long k = dmaj == 0 ? 0 : (2 * lo * dmin + dmaj) / (2 * dmaj);
+        long long d = 2 * (lo + 1) * dmin - dmaj - 2 * dmaj * k;
+        int x = steep ? min0 + (int)k * min_step : maj0 + (int)lo * maj_step;
+        int y = steep ? maj0 + (int)lo * maj_step : min0 + (int)k * min_step;
+
+        const ptrdiff_t pixel_step = 3 * (ptrdiff_t)x_step;
+        const ptrdiff_t row_step = (ptrdiff_t)image.step * y_step;
+        const ptrdiff_t maj_advance = steep ? row_step : pixel_step;
+        const ptrdiff_t min_advance = steep ? pixel_step : row_step;
+        const long long d_min = 2 * dmin, d_both = 2 * (dmin - dmaj);
+        uchar* p = image.ptr<uchar>(y) + 3 * x;
+
+        for (long long i = lo; ; i++) {
+            p[0] = color[0];
+            p[1] = color[1];
+            p[2] = color[2];
+            if (i == hi) {
+                break;
+            }
+            p += maj_advance;
+            if (d < 0) {
+                d += d_min;
+            }
+            else {
+                p += min_advance;
+                d += d_both;
+            }
+        }
+    }
+
+    // dst = (dst * (255 - a) + src * a) / 255, rounded.
+    static inline uchar blend8(uchar dst, uchar src, int a) {
+        int t = dst * (255 - a) + src * a + 128;
+        return (uchar)((t + (t >> 8)) >> 8);
+    }
+
+    static inline void blendPixel(uchar* p, const cv::Vec3b& color, int a) {
+        p[0] = blend8(p[0], color[0], a);
+        p[1] = blend8(p[1], color[1], a);
+        p[2] = blend8(p[2], color[2], a);
+    }
+
+    // Blends count consecutive pixels of a row with one weight.
+    static void blendRun(uchar* p, int count, const cv::Vec3b& color, int a) {
+        if (a == 0) {
+            return;
+        }
+        int i = 0;
+#if LINE_DRAWER_SSE2
+        // 16 pixels = 48 bytes = three registers; the color pattern repeats with the same period.
+        alignas(16) uchar pattern[48];
+        for (int j = 0; j < 48; j++) {
+            pattern[j] = color[j % 3];
+        }
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i wa = _mm_set1_epi16((short)a), wb = _mm_set1_epi16((short)(255 - a));
+        const __m128i round = _mm_set1_epi16(128);
+        __m128i c_lo[3], c_hi[3];
+        for (int j = 0; j < 3; j++) {
+            __m128i c = _mm_load_si128((const __m128i*)(pattern + 16 * j));
+            c_lo[j] = _mm_mullo_epi16(_mm_unpacklo_epi8(c, zero), wa);
+            c_hi[j] = _mm_mullo_epi16(_mm_unpackhi_epi8(c, zero), wa);
+        }
+        for (; i + 16 <= count; i += 16) {
+            for (int j = 0; j < 3; j++) {
+                __m128i* q = (__m128i*)(p + 3 * i + 16 * j);
+                __m128i d = _mm_loadu_si128(q);
+                __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), wb), c_lo[j]), round);
+                __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), wb), c_hi[j]), round);
+                lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+                hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+                _mm_storeu_si128(q, _mm_packus_epi16(lo, hi));
+            }
+        }
+#endif
+        for (; i < count; i++) {
+            blendPixel(p + 3 * i, color, a);
+        }
+    }
+
+    static void drawClippedWu(cv::Mat& image, float x0, float y0, float x1, float y1, const cv::Vec3b& color) {
+        // Endpoints are drawn solid, like drawLineWu.
+        const float ex0 = x0, ey0 = y0, ex1 = x1, ey1 = y1;
+
+        bool steep = std::abs(y1 - y0) > std::abs(x1 - x0);
+        if (steep) {
+            std::swap(x0, y0);
+            std::swap(x1, y1);
+        }
+        if (x0 > x1) {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+        }
+
+        float dx = x1 - x0;
+        float gradient = (dx == 0) ? 1.0f : (y1 - y0) / dx;
+        int maj_size = steep ? image.rows : image.cols;
+        int min_size = steep ? image.cols : image.rows;
+
+        // Interior columns of drawLineWu are [(int)x0 + 1, (int)x1 - 1].
+        int first = static_cast<int>(x0) + 1, last = static_cast<int>(x1) - 1;
+        clipWuColumns(first, last, (double)static_cast<int>(x0), y0, gradient, maj_size, min_size);
+
+        if (first <= last) {
+            // drawLineWu starts at y0 + gradient on column (int)x0 + 1.
+            float y_first = y0 + gradient * (float)(first - static_cast<int>(x0));
+            int32_t y = (int32_t)std::lround(y_first * 65536.0f);
+            int32_t step = (int32_t)std::lround(gradient * 65536.0f);
+
+            if (step == 0) {
+                // Axis-aligned: constant weights for the whole run.
+                int yi = y >> 16, a = (y >> 8) & 0xFF;
+                if (!steep) {
+                    if (yi >= 0 && yi < min_size) {
+                        blendRun(image.ptr<uchar>(yi) + 3 * first, last - first + 1, color, 255 - a);
+                    }
+                    if (yi + 1 >= 0 && yi + 1 < min_size) {
+                        blendRun(image.ptr<uchar>(yi + 1) + 3 * first, last - first + 1, color, a);
+                    }
+                }
+                else {
+                    for (int x = first; x <= last; x++) {
+                        uchar* row = image.ptr<uchar>(x);
+                        if (yi >= 0 && yi < min_size) {
+                            blendPixel(row + 3 * yi, color, 255 - a);
+                        }
+                        if (yi + 1 >= 0 && yi + 1 < min_size) {
+                            blendPixel(row + 3 * (yi + 1), color, a);
+                        }
+                    }
+                }
+            }
+            else {
+                const size_t row_step = image.step;
+                uchar* base = image.data;
+                for (int x = first; x <= last; x++, y += step) {
+                    int yi = y >> 16, a = (y >> 8) & 0xFF;
+                    // Steep: (yi, yi + 1) are neighbours in row x; otherwise the same column of rows yi, yi + 1.
+                    if (yi >= 0 && yi < min_size) {
+                        blendPixel(steep ? base + row_step * x + 3 * yi : base + row_step * yi + 3 * x, color, 255 - a);
+                    }
+                    if (yi + 1 >= 0 && yi + 1 < min_size) {
+                        blendPixel(steep ? base + row_step * x + 3 * (yi + 1) : base + row_step * (yi + 1) + 3 * x,
+                            color, a);
+                    }
+                }
+            }
+        }
+
+        setPixelSafe(image, static_cast<int>(ex0), static_cast<int>(ey0), color);
+        setPixelSafe(image, static_cast<int>(ex1), static_cast<int>(ey1), color);
+    }
+
+    // sRGB <-> linear light, 12-bit linear values.
+    struct GammaTables {
+        uint16_t to_linear[256];
+        uint8_t to_srgb[4096];
+
+        GammaTables() {
+            for (int i = 0; i < 256; i++) {
+                double c = i / 255.0;
+                double l = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+                to_linear[i] = (uint16_t)std::lround(l * 4095.0);
+            }
+            for (int i = 0; i < 4096; i++) {
+                double l = i / 4095.0;
+                double c = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+                to_srgb[i] = (uint8_t)std::lround(c * 255.0);
+            }
+        }
+    };
+
+    static const GammaTables& gammaTables() {
+        static const GammaTables tables;
+        return tables;
+    }
+
+    // Coverage a in [0, 256].
+    static inline void blendLinear(uchar* p, const cv::Vec3b& color, const uint16_t linear[3], int a) {
+        if (a <= 0) {
+            return;
+        }
+        if (a >= 256) {
+            p[0] = color[0];
+            p[1] = color[1];
+            p[2] = color[2];
+            return;
+        }
+        const GammaTables& lut = gammaTables();
+        for (int c = 0; c < 3; c++) {
+            int d = lut.to_linear[p[c]];
+            p[c] = lut.to_srgb[d + (((linear[c] - d) * a) >> 8)];
+        }
+    }
+
+    static void drawWuGamma(cv::Mat& image, float fx0, float fy0, float fx1, float fy1,
+        const cv::Vec3b& color, const uint16_t linear[3]) {
+        bool steep = std::abs(fy1 - fy0) > std::abs(fx1 - fx0);
+        if (steep) {
+            std::swap(fx0, fy0);
+            std::swap(fx1, fy1);
+        }
+        if (fx0 > fx1) {
+            std::swap(fx0, fx1);
+            std::swap(fy0, fy1);
+        }
+
+        const int maj_size = steep ? image.rows : image.cols;
+        const int min_size = steep ? image.cols : image.rows;
+        auto plot = [&](int x, int y, int a) {
+            if (x >= 0 && x < maj_size && y >= 0 && y < min_size) {
+                blendLinear(steep ? image.ptr<uchar>(x) + 3 * y : image.ptr<uchar>(y) + 3 * x, color, linear, a);
+            }
+        };
+
+        // 24.8 fixed point.
+        const int32_t x0 = (int32_t)std::lround(fx0 * 256.0f), y0 = (int32_t)std::lround(fy0 * 256.0f);
+        const int32_t x1 = (int32_t)std::lround(fx1 * 256.0f), y1 = (int32_t)std::lround(fy1 * 256.0f);
+        const int64_t dx = x1 - x0, dy = y1 - y0;
+        // Minor coordinate change per major pixel, 16.16.
+        const int64_t gradient = dx == 0 ? 65536 : (dy * 65536) / dx;
+
+        // Endpoints: the pixel column the end falls in, covered by the part of the line inside it (xgap)
+        // and split between the two minor pixels straddled by the line there.
+        auto endpoint = [&](int32_t x, int32_t y, bool first, int& column) -> int64_t {
+            int32_t x_end = (x + 128) & ~255;                                // nearest pixel center column
+            int64_t y_end = (int64_t)y * 256 + gradient * (x_end - x) / 256; // 16.16
+            int xgap = first ? 256 - ((x + 128) & 255) : ((x + 128) & 255);
+            if (dx == 0) {
+                xgap = 256;
+            }
+            column = x_end >> 8;
+            int yi = (int)(y_end >> 16), frac = (int)((y_end >> 8) & 255);
+            plot(column, yi, ((256 - frac) * xgap) >> 8);
+            plot(column, yi + 1, (frac * xgap) >> 8);
+            return y_end;
+        };
+
+        int first_col, last_col;
+        int64_t y = endpoint(x0, y0, true, first_col) + gradient;
+        endpoint(x1, y1, false, last_col);
+        if (first_col == last_col) {
+            return;
+        }
+
+        // Interior columns, clipped to the image.
+        int first = first_col + 1, last = last_col - 1;
+        int clipped_first = first;
+        clipWuColumns(clipped_first, last, first, y / 65536.0, gradient / 65536.0, maj_size, min_size);
+        if (clipped_first > last) {
+            return;
+        }
+        y += gradient * (clipped_first - first);
+
+        const size_t row_step = image.step;
+        uchar* base = image.data;
+        for (int x = clipped_first; x <= last; x++, y += gradient) {
+            int yi = (int)(y >> 16), a = (int)((y >> 8) & 255);
+            if (yi >= 0 && yi < min_size) {
+                blendLinear(steep ? base + row_step * x + 3 * yi : base + row_step * yi + 3 * x, color, linear, 256 - a);
+            }
+            if (yi + 1 >= 0 && yi + 1 < min_size) {
+                blendLinear(steep ? base + row_step * x + 3 * (yi + 1) : base + row_step * (yi + 1) + 3 * x,
+                    color, linear, a);
+            }
+        }
+    }
+
     static void setPixelSafe(cv::Mat& image, int x, int y, const cv::Vec3b& color) {
         if (x >= 0 && x < image.cols && y >= 0 && y < image.rows) {
             image.at<cv::Vec3b>(y, x) = color;
@@ -136,9 +521,65 @@ bool getPointFromUser(const std::string& prompt, int& x, int& y, int max_x, int
     return true;
 }
 
-int main() {
+// Draws 1M random segments (a third of them crossing the image border) one by one and as a batch.
+void runBenchmark() {
+    const int width = 1920, height = 1080, count = 1000000;
+    std::mt19937 rng(332);
+    std::uniform_int_distribution<int> coord_x(-width / 4, width + width / 4);
+    std::uniform_int_distribution<int> coord_y(-height / 4, height + height / 4);
+
+    std::vector<cv::Vec4i> segments(count);
+    std::vector<cv::Vec4f> segments_f(count);
+    for (int i = 0; i < count; i++) {
+        segments[i] = cv::Vec4i(coord_x(rng), coord_y(rng), coord_x(rng), coord_y(rng));
+        segments_f[i] = cv::Vec4f((float)segments[i][0], (float)segments[i][1], (float)segments[i][2], (float)segments[i][3]);
+    }
+    // Every 16th segment is axis-aligned.
+    for (int i = 0; i < count; i += 16) {
+        segments[i][3] = segments[i][1];
+        segments_f[i][3] = segments_f[i][1];
+    }
+
+    auto timed = [](const char* name, auto&& draw) {
+        auto start = std::chrono::steady_clock::now();
+        draw();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << name << ": " << ms << " ms" << std::endl;
+    };
+
+    cv::Vec3b color(0, 0, 255);
+    cv::Mat single(height, width, CV_8UC3, cv::Scalar(0, 0, 0)), batch = single.clone();
+    timed("Bresenham, one by one", [&]() {
+        for (const cv::Vec4i& s : segments) {
+            LineDrawer::drawLineBresenham(single, s[0], s[1], s[2], s[3], color);
+        }
+    });
+    timed("Bresenham, batch", [&]() { LineDrawer::drawLinesBresenham(batch, segments, color); });
+    std::cout << "Bresenham images identical: " << (cv::norm(single, batch, cv::NORM_INF) == 0 ? "yes" : "no")
+        << std::endl;
+
+    single.setTo(cv::Scalar(0, 0, 0));
+    batch.setTo(cv::Scalar(0, 0, 0));
+    timed("Wu, one by one", [&]() {
+        for (const cv::Vec4f& s : segments_f) {
+            LineDrawer::drawLineWu(single, s[0], s[1], s[2], s[3], color);
+        }
+    });
+    timed("Wu, batch", [&]() { LineDrawer::drawLinesWu(batch, segments_f, color); });
+    // Fixed-point stepping rounds the blend weights differently from drawLineWu, so a level or two is expected;
+    // a clipping error shows up as a whole missing pixel.
+    std::cout << "Wu max difference: " << cv::norm(single, batch, cv::NORM_INF) << " levels" << std::endl;
+    timed("Wu gamma-correct, batch", [&]() { LineDrawer::drawLinesWuGamma(batch, segments_f, color); });
+}
+
+int main(int argc, char** argv) {
     setlocale(LC_ALL, "rus");
 
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        runBenchmark();
+        return 0;
+    }
+
     const int width = 800;
     const int height = 600;
 
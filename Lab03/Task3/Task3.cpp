@@ -4,6 +4,8 @@
 #include <random>
 #include <cstdlib>
 #include <ctime>
+#include <chrono>
+#include <thread>
 
 using namespace cv;
 using namespace std;
@@ -19,7 +21,11 @@ namespace task3 {
         int r, g, b;
     };
 
-    Mat colorMatrix;
+    struct ColoredTriangle
+    {
+        MyPoint v[3];
+    };
+
     Mat image;
     vector<MyPoint> clickPoints;
 
@@ -99,39 +105,166 @@ namespace task3 {
 
     }
 
-    void createPolygon() {
-        int min_x = findMinX(clickPoints);
-        int max_x = findMaxX(clickPoints);
-        int min_y = findMinY(clickPoints);
-        int max_y = findMaxY(clickPoints);
-        for (int y = min_y; y <= max_y; y++) {
-            for (int x = min_x; x <= max_x; x++) {
-                cv::Mat A = (cv::Mat_<float>(3, 3) <<
-                    clickPoints[0].x, clickPoints[1].x, clickPoints[2].x,
-                    clickPoints[0].y, clickPoints[1].y, clickPoints[2].y,
-                    1, 1, 1);
-                cv::Mat B = (cv::Mat_<float>(3, 1) << x, y, 1);
-                cv::Mat coords = A.inv() * B;
-
-                if (cv::checkRange(coords, true, 0, 0.0, 1.0)) {
-                    auto expr = colorMatrix * coords;
-                    cv::Mat res = expr;
-                    image.at<cv::Vec3b>(Point(x, y)) = cv::Vec3b(res.at<float>(0, 0),
-                        res.at<float>(0, 1),
-                        res.at<float>(0, 2));
+    // Edge function of a -> b at (x, y): positive on the left of the edge (clockwise on screen).
+    inline long long edgeFunction(const MyPoint& a, const MyPoint& b, long long x, long long y) {
+        return (long long)(b.x - a.x) * (y - a.y) - (long long)(b.y - a.y) * (x - a.x);
+    }
+
+    // Rows [rowBegin, rowEnd) of a gradient triangle. Barycentric weights are edge functions set up once;
+    // for every row the span where all three are non-negative is solved directly, and the colour is stepped
+    // along it in 16.16 fixed point. Top-left rule: pixels on a shared edge belong to one triangle only.
+    void rasterizeGradientTriangle(Mat& img, MyPoint a, MyPoint b, MyPoint c, int rowBegin, int rowEnd) {
+        long long area = edgeFunction(a, b, c.x, c.y);
+        if (area == 0) {
+            return;
+        }
+        if (area < 0) {
+            std::swap(b, c);
+            area = -area;
+        }
+
+        const MyPoint* v[3] = { &a, &b, &c };
+        // w[i] belongs to the edge opposite v[i]; dwdx[i] / dwdy[i] are its steps.
+        long long dwdx[3], dwdy[3], bias[3];
+        for (int i = 0; i < 3; i++) {
+            const MyPoint& p = *v[(i + 1) % 3];
+            const MyPoint& q = *v[(i + 2) % 3];
+            dwdx[i] = -(long long)(q.y - p.y);
+            dwdy[i] = q.x - p.x;
+            bool topLeft = (q.y == p.y && q.x < p.x) || q.y > p.y;
+            bias[i] = topLeft ? 0 : -1;
+        }
+
+        // Channels in image order (g, b, r), as the clicked points are shown.
+        long long col[3][3];
+        for (int i = 0; i < 3; i++) {
+            col[i][0] = v[i]->g;
+            col[i][1] = v[i]->b;
+            col[i][2] = v[i]->r;
+        }
+        long long dcdx[3];
+        for (int ch = 0; ch < 3; ch++) {
+            long long num = 0;
+            for (int i = 0; i < 3; i++) {
+                num += dwdx[i] * col[i][ch];
+            }
+            dcdx[ch] = (num * 65536) / area;
+        }
+
+        int minX = std::max(0, std::min({ a.x, b.x, c.x })), maxX = std::min(img.cols - 1, std::max({ a.x, b.x, c.x }));
+        int minY = std::max(rowBegin, std::min({ a.y, b.y, c.y })), maxY = std::min(rowEnd - 1, std::max({ a.y, b.y, c.y }));
+
+        // w0[i] is the edge function at (minX, y), stepped down by dwdy[i] per row.
+        long long w0[3];
+        for (int i = 0; i < 3; i++) {
+            w0[i] = edgeFunction(*v[(i + 1) % 3], *v[(i + 2) % 3], minX, minY);
+        }
+        for (int y = minY; y <= maxY; y++, w0[0] += dwdy[0], w0[1] += dwdy[1], w0[2] += dwdy[2]) {
+            int xl = minX, xr = maxX;
+            for (int i = 0; i < 3; i++) {
+                // w0 + dwdx * (x - minX) + bias >= 0
+                long long need = -bias[i] - w0[i];
+                if (dwdx[i] > 0) {
+                    long long k = need <= 0 ? 0 : (need + dwdx[i] - 1) / dwdx[i];
+                    xl = (int)std::max<long long>(xl, minX + k);
+                }
+                else if (dwdx[i] < 0) {
+                    if (need > 0) {
+                        xr = -1;
+                        break;
+                    }
+                    xr = (int)std::min<long long>(xr, minX + (-need) / (-dwdx[i]));
+                }
+                else if (need > 0) {
+                    xr = -1;
+                    break;
+                }
+            }
+            if (xl > xr) {
+                continue;
+            }
+
+            long long dx = xl - minX;
+            int32_t color[3];
+            for (int ch = 0; ch < 3; ch++) {
+                long long num = 0;
+                for (int i = 0; i < 3; i++) {
+                    num += (w0[i] + dwdx[i] * dx) * col[i][ch];
                 }
+                color[ch] = (int32_t)((num * 65536) / area) + 32768;
+            }
+            const int32_t step0 = (int32_t)dcdx[0], step1 = (int32_t)dcdx[1], step2 = (int32_t)dcdx[2];
+
+            uchar* p = img.ptr<uchar>(y) + 3 * xl;
+            for (int x = xl; x <= xr; x++, p += 3) {
+                p[0] = (uchar)std::clamp(color[0] >> 16, 0, 255);
+                p[1] = (uchar)std::clamp(color[1] >> 16, 0, 255);
+                p[2] = (uchar)std::clamp(color[2] >> 16, 0, 255);
+                color[0] += step0;
+                color[1] += step1;
+                color[2] += step2;
+            }
+        }
+    }
+
+    void fillGradientTriangle(Mat& img, const MyPoint& a, const MyPoint& b, const MyPoint& c) {
+        rasterizeGradientTriangle(img, a, b, c, 0, img.rows);
+    }
+
+    // Draws the triangles in order. Threads own horizontal bands of the image, so overlapping
+    // triangles still end up in submission order.
+    void fillGradientTriangles(Mat& img, const vector<ColoredTriangle>& triangles) {
+        int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+        int bands = std::max(1, std::min(threads, img.rows / 32));
+        auto band = [&](int i) {
+            int y0 = (int)((long long)img.rows * i / bands), y1 = (int)((long long)img.rows * (i + 1) / bands);
+            for (const ColoredTriangle& t : triangles) {
+                rasterizeGradientTriangle(img, t.v[0], t.v[1], t.v[2], y0, y1);
+            }
+        };
+        vector<std::thread> workers;
+        for (int i = 1; i < bands; i++) {
+            workers.emplace_back(band, i);
+        }
+        band(0);
+        for (auto& w : workers) {
+            w.join();
+        }
+    }
+
+    void createPolygon() {
+        fillGradientTriangle(image, clickPoints[0], clickPoints[1], clickPoints[2]);
+    }
+
+    // Fills the canvas with a grid of random-coloured triangles (two per cell).
+    void createGradientMesh(int cellsX, int cellsY) {
+        vector<MyPoint> grid;
+        for (int j = 0; j <= cellsY; j++) {
+            for (int i = 0; i <= cellsX; i++) {
+                int x = std::min(WIDTH - 1, i * WIDTH / cellsX), y = std::min(HEIGHT - 1, j * HEIGHT / cellsY);
+                grid.push_back(MyPoint(x, y, rand() % MAX_COLOR, rand() % MAX_COLOR, rand() % MAX_COLOR));
+            }
+        }
+        vector<ColoredTriangle> triangles;
+        for (int j = 0; j < cellsY; j++) {
+            for (int i = 0; i < cellsX; i++) {
+                const MyPoint& p00 = grid[j * (cellsX + 1) + i];
+                const MyPoint& p10 = grid[j * (cellsX + 1) + i + 1];
+                const MyPoint& p01 = grid[(j + 1) * (cellsX + 1) + i];
+                const MyPoint& p11 = grid[(j + 1) * (cellsX + 1) + i + 1];
+                triangles.push_back({ { p00, p10, p11 } });
+                triangles.push_back({ { p00, p11, p01 } });
             }
         }
+
+        auto start = chrono::steady_clock::now();
+        fillGradientTriangles(image, triangles);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << triangles.size() << " triangles in " << ms << " ms" << endl;
     }
 
     void createTriangle() {
         if (clickPoints.size() == 3) {
-            colorMatrix = Mat::zeros(3, 3, CV_32FC1);
-            for (int i = 0; i < 3; i++) {
-                colorMatrix.col(i).at<float>(0) = clickPoints[i].g;
-                colorMatrix.col(i).at<float>(1) = clickPoints[i].b;
-                colorMatrix.col(i).at<float>(2) = clickPoints[i].r;
-            }
             createPolygon();
             imshow("Canvas Window", image);
         }
@@ -153,6 +286,7 @@ int main2() {
     cout << "Interactive canvas ready!" << endl;
     cout << "Left click - add point" << endl;
     cout << "right click - clear canvas" << endl;
+    cout << "m - random gradient mesh" << endl;
 
     while (true) {
         int key = cv::waitKey(1) & 0xFF;
@@ -163,6 +297,10 @@ int main2() {
             cout << "space pressed" << endl;
             createTriangle();
         }
+        else if (key == 'm') {
+            createGradientMesh(64, 48);
+            imshow("Canvas Window", image);
+        }
     }
 
     waitKey(0);
@@ -1,20 +1,24 @@
 #include "provider.h"
 #include "Lab05/App.h"
+#include "Lab05/LSystemCache.h"
 #include <random>
 #include <chrono>
 #include <fstream>
 #include <sstream>
 #include <cmath>
-#include <stack>
-#include <queue>
 #include <thread>
+#include <mutex>
+#include <climits>
+#include <cfloat>
+#include <atomic>
+#include <cstring>
 #include <filesystem>
 
 using namespace Lab05;
 
 static std::shared_ptr<LSystem> currentLSystem;
 static std::shared_ptr<LSystemGenerator> currentGenerator;
-static std::string currentSequence;
+static uint64_t currentFileHash = 0;
 static int currentIterations = 1;
 static std::vector<std::string> lSystemFiles = {
     "../Lab05/LSystems/Sierpinski Curve.txt",
@@ -31,14 +35,35 @@ static std::vector<int> iterationsCounts = { 1, 1, 1, 1, 1, 1, 1, 1, 1};
 static int selectedLSystem = 0;
 
 static bool needsRedraw = false;
+// Export runs on its own thread; the status text is shared with it under exportMutex.
+static std::string exportStatus;
+static std::mutex exportMutex;
+static std::atomic<bool> exportRunning{ false };
+static std::atomic<uint64_t> exportWritten{ 0 };
+static std::atomic<uint64_t> exportTotal{ 0 };
+const uint64_t EXPORT_LIMIT = uint64_t(1) << 30;
 static bool lsystem_running = false;
+static bool lsystemDrawn = false;
 static int current_draw_step = 0;
 static int total_draw_steps = 0;
 
 static cv::Mat midpointCanvas;
 static cv::Mat lsystemCanvas;
+// The last compiled fractal, kept to redraw it on a canvas of another size.
+static std::shared_ptr<const TurtlePath> currentPath;
+static std::mutex pathMutex;
+// Every symbol may become a segment of the turtle path. Paths of longer sequences are not kept:
+// they are drawn in chunks straight from the generator, and a new canvas size draws them again.
+const uint64_t PATH_LIMIT = uint64_t(1) << 22;
+// A new canvas size waits until the drawing thread is done with the old canvas.
+static bool canvasResizePending = false;
+static LSystemCache lsystemCache;
+static int cacheBudgetMb = 256;
+// Seed of the random angles ('@'); it is part of the cache key of turtle paths.
+static unsigned int lsystemSeed = std::random_device{}();
 const int CANVAS_WIDTH = 800;
 const int CANVAS_HEIGHT = 600;
+static int lsystemCanvasSize[2] = { CANVAS_WIDTH, CANVAS_HEIGHT };
 
 void printCurrentDirectory() {
     try {
@@ -164,30 +189,208 @@ LSystemGenerator::LSystemGenerator(std::shared_ptr<LSystem> lsystem)
 }
 
 std::string LSystemGenerator::generateSequence(int iterations) {
-    std::string current = lSystem->axiom;
+    return expandParallel(iterations);
+}
+
+uint64_t LSystemGenerator::sequenceLength(int iterations) const {
+    // length[c] = length of symbol c after k rewrites, for k = 0..iterations.
+    std::vector<uint64_t> length(256, 1), next(256);
+    for (int k = 0; k < iterations; k++) {
+        next = length;
+        for (const auto& rule : lSystem->rules) {
+            uint64_t total = 0;
+            for (char symbol : rule.second) {
+                uint64_t add = length[(unsigned char)symbol];
+                total = (total > UINT64_MAX - add) ? UINT64_MAX : total + add;
+            }
+            next[(unsigned char)rule.first] = total;
+        }
+        length.swap(next);
+    }
+
+    uint64_t total = 0;
+    for (char symbol : lSystem->axiom) {
+        uint64_t add = length[(unsigned char)symbol];
+        total = (total > UINT64_MAX - add) ? UINT64_MAX : total + add;
+    }
+    return total;
+}
+
+std::string LSystemGenerator::expandParallel(int iterations, unsigned int threadCount) const {
+    return expandParallel(lSystem->axiom, iterations, threadCount);
+}
 
-    for (int i = 0; i < iterations; i++) {
-        std::string next;
+std::string LSystemGenerator::expandParallel(const std::string& start, int iterations, unsigned int threadCount) const {
+    const std::string* rule[256] = {};
+    for (const auto& r : lSystem->rules) {
+        if (r.second.size() != 1 || r.second[0] != r.first) {
+            rule[(unsigned char)r.first] = &r.second;
+        }
+    }
+    auto addSaturated = [](uint64_t a, uint64_t b) {
+        return (a > UINT64_MAX - b) ? UINT64_MAX : a + b;
+    };
 
-        for (char symbol : current) {
-            auto it = lSystem->rules.find(symbol);
-            if (it != lSystem->rules.end()) {
-                next += it->second;
+    // length[k][c] = length of symbol c after k rewrites.
+    std::vector<std::array<uint64_t, 256>> length(iterations + 1);
+    length[0].fill(1);
+    for (int k = 1; k <= iterations; k++) {
+        for (int c = 0; c < 256; c++) {
+            uint64_t total = 1;
+            if (rule[c]) {
+                total = 0;
+                for (char symbol : *rule[c]) {
+                    total = addSaturated(total, length[k - 1][(unsigned char)symbol]);
+                }
             }
-            else {
-                next += symbol;
+            length[k][c] = total;
+        }
+    }
+
+    uint64_t total = 0;
+    for (char symbol : start) {
+        total = addSaturated(total, length[iterations][(unsigned char)symbol]);
+    }
+    if (total == UINT64_MAX || total >= std::string().max_size()) {
+        throw std::length_error("L-system sequence is too long to materialize");
+    }
+
+    // Subtrees up to blockDepth are short, so they are expanded once per symbol and copied.
+    const uint64_t blockLimit = 4096;
+    int blockDepth = 0;
+    while (blockDepth < iterations) {
+        uint64_t widest = 0;
+        for (int c = 0; c < 256; c++) {
+            widest = std::max(widest, length[blockDepth + 1][c]);
+        }
+        if (widest > blockLimit) break;
+        blockDepth++;
+    }
+    std::vector<std::string> block(256);
+    for (int c = 0; c < 256; c++) {
+        block[c] = std::string(1, (char)c);
+    }
+    for (int k = 0; k < blockDepth; k++) {
+        std::vector<std::string> next(256);
+        for (int c = 0; c < 256; c++) {
+            if (!rule[c]) {
+                next[c] = block[c];
+                continue;
+            }
+            for (char symbol : *rule[c]) {
+                next[c] += block[(unsigned char)symbol];
             }
         }
+        block.swap(next);
+    }
 
-        current = next;
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (total < (uint64_t(1) << 16)) {
+        threadCount = 1;
     }
 
-    return current;
+    // Work items are runs of symbols at one depth of the rewrite tree, each expanding to about grain
+    // symbols. A symbol longer than that is replaced by its production one level down, so the threads
+    // get many pieces of similar size.
+    struct Item {
+        const std::string* text;
+        size_t begin, end;
+        int depth;
+        uint64_t offset;
+    };
+    const uint64_t grain = std::max<uint64_t>(total / (8 * threadCount), 1);
+    std::vector<Item> items;
+    uint64_t offset = 0;
+    auto cut = [&](const std::string* text, size_t begin, size_t end, int depth, auto& self) -> void {
+        size_t runBegin = begin;
+        uint64_t runOffset = offset;
+        for (size_t i = begin; i < end; i++) {
+            unsigned char symbol = (*text)[i];
+            uint64_t symbolLength = length[depth][symbol];
+            if (symbolLength > grain && rule[symbol] && depth > blockDepth) {
+                if (runBegin < i) {
+                    items.push_back({ text, runBegin, i, depth, runOffset });
+                }
+                self(rule[symbol], 0, rule[symbol]->size(), depth - 1, self);
+                runBegin = i + 1;
+                runOffset = offset;
+                continue;
+            }
+            offset += symbolLength;
+            if (offset - runOffset >= grain) {
+                items.push_back({ text, runBegin, i + 1, depth, runOffset });
+                runBegin = i + 1;
+                runOffset = offset;
+            }
+        }
+        if (runBegin < end) {
+            items.push_back({ text, runBegin, end, depth, runOffset });
+        }
+    };
+    cut(&start, 0, start.size(), iterations, cut);
+
+    std::string result(total, '\0');
+    char* out = result.data();
+
+    auto writeItem = [&](const Item& item) {
+        struct Frame {
+            const std::string* text;
+            size_t pos, end;
+            int depth;
+        };
+        std::vector<Frame> stack;
+        stack.push_back({ item.text, item.begin, item.end, item.depth });
+        char* dst = out + item.offset;
+        while (!stack.empty()) {
+            Frame& top = stack.back();
+            if (top.depth <= blockDepth) {
+                // Every symbol of the run is a block: copy them without touching the stack.
+                const unsigned char* symbols = (const unsigned char*)top.text->data();
+                for (size_t i = top.pos; i < top.end; i++) {
+                    const std::string& text = block[symbols[i]];
+                    memcpy(dst, text.data(), text.size());
+                    dst += text.size();
+                }
+                stack.pop_back();
+                continue;
+            }
+            if (top.pos == top.end) {
+                stack.pop_back();
+                continue;
+            }
+            unsigned char symbol = (*top.text)[top.pos++];
+            if (top.depth > blockDepth && rule[symbol]) {
+                stack.push_back({ rule[symbol], 0, rule[symbol]->size(), top.depth - 1 });
+            }
+            else {
+                const std::string& text = block[symbol];
+                memcpy(dst, text.data(), text.size());
+                dst += text.size();
+            }
+        }
+    };
+
+    std::atomic<size_t> nextItem{ 0 };
+    auto worker = [&]() {
+        for (size_t i = nextItem++; i < items.size(); i = nextItem++) {
+            writeItem(items[i]);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned int t = 1; t < threadCount; t++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : workers) {
+        t.join();
+    }
+    return result;
 }
 
-FractalDrawer::FractalDrawer(cv::Mat targetCanvas)
-    : canvas(targetCanvas), currentPosition(PointF(0, 0)),
-    currentDirection(0), rng(std::random_device{}()) {
+FractalDrawer::FractalDrawer(cv::Mat targetCanvas, unsigned int seed)
+    : canvas(targetCanvas), randomSeed(seed), rng(randomSeed) {
 }
 
 PointF FractalDrawer::calculateNextPosition(float stepLength, PointF position, double direction) {
@@ -197,178 +400,206 @@ PointF FractalDrawer::calculateNextPosition(float stepLength, PointF position, d
     return PointF(nextX, nextY);
 }
 
-void FractalDrawer::drawLine(const PointF& p1, const PointF& p2, int colorValue, float thickness) {
-    cv::Point cvP1(static_cast<int>(p1.x), static_cast<int>(p1.y));
-    cv::Point cvP2(static_cast<int>(p2.x), static_cast<int>(p2.y));
-
-    int color = std::max(0, std::min(255, colorValue));
-    cv::Scalar lineColor(color, color, color);
-
-    cv::line(canvas, cvP1, cvP2, lineColor, static_cast<int>(thickness));
-}
-
-void FractalDrawer::calculateBounds(const std::string& sequence, double angleIncrement, float stepLength, float stepDecreasePercent) {
-    std::stack<std::tuple<PointF, double, float>> stack;
-    randomAngles = std::queue<double>();
+template<class Emit>
+void FractalDrawer::walk(const LSystemGenerator& generator, int iterations, double startDirection, double angleIncrement,
+    float stepLength, bool treeStyle, Emit&& emit) {
+    struct TurtleState {
+        PointF position;
+        double direction;
+        float step;
+    };
 
-    minX = maxX = currentPosition.x;
-    minY = maxY = currentPosition.y;
+    std::vector<TurtleState> stack;
+    rng.seed(randomSeed);
 
-    PointF currentPos = currentPosition;
-    double currentDir = currentDirection;
-    float currentStep = stepLength;
+    TurtleState state{ PointF(0, 0), treeStyle ? 90.0 : startDirection, stepLength };
     double initialAngle = angleIncrement;
+    int branchDepth = 0;
 
-    for (char symbol : sequence) {
+    generator.expand(iterations, [&](char symbol) {
         if (isalpha(symbol)) {
-            currentStep -= currentStep * (stepDecreasePercent / 100.0f);
-            PointF nextPos = calculateNextPosition(currentStep, currentPos, currentDir);
-
-            minX = std::min(minX, static_cast<double>(nextPos.x));
-            minY = std::min(minY, static_cast<double>(nextPos.y));
-            maxX = std::max(maxX, static_cast<double>(nextPos.x));
-            maxY = std::max(maxY, static_cast<double>(nextPos.y));
+            int color = 0;
+            float thickness = 2.0f;
+            if (treeStyle) {
+                thickness = std::max(2.0f, 15.0f - branchDepth * 1.8f);
+                color = (branchDepth < 2) ? 80 - branchDepth * 10 : std::min(150, 60 + branchDepth * 15);
+                state.step *= 0.92f;
+            }
 
-            currentPos = nextPos;
+            PointF nextPos = calculateNextPosition(state.step, state.position, state.direction);
+            emit(TurtleSegment{ state.position, nextPos, thickness,
+                static_cast<uint16_t>(std::min(branchDepth, 65535)), static_cast<uint8_t>(color) });
+            state.position = nextPos;
         }
         else {
             switch (symbol) {
             case '+':
-                currentDir += angleIncrement;
+                state.direction += angleIncrement;
                 break;
             case '-':
-                currentDir -= angleIncrement;
+                state.direction -= angleIncrement;
                 break;
             case '[':
-                stack.push(std::make_tuple(currentPos, currentDir, currentStep));
+                stack.push_back(state);
+                branchDepth++;
                 break;
             case ']':
                 if (!stack.empty()) {
-                    auto savedState = stack.top();
-                    stack.pop();
-                    currentPos = std::get<0>(savedState);
-                    currentDir = std::get<1>(savedState);
-                    currentStep = std::get<2>(savedState);
+                    state = stack.back();
+                    stack.pop_back();
+                    branchDepth--;
                 }
                 break;
             case '@':
                 std::uniform_real_distribution<double> dist(0, initialAngle);
-                double randomAngle = dist(rng);
-                randomAngles.push(randomAngle);
-                angleIncrement = randomAngle;
+                angleIncrement = dist(rng);
                 break;
             }
         }
-    }
+    });
 }
 
-void FractalDrawer::draw(const std::string& sequence, double angleIncrement, float stepLength) {
-    printf("Starting draw: sequence length=%zu\n", sequence.length());
+static void extendBounds(TurtlePath& path, const PointF& p) {
+    path.minX = std::min(path.minX, static_cast<double>(p.x));
+    path.minY = std::min(path.minY, static_cast<double>(p.y));
+    path.maxX = std::max(path.maxX, static_cast<double>(p.x));
+    path.maxY = std::max(path.maxY, static_cast<double>(p.y));
+}
 
-    canvas = cv::Scalar(255, 255, 255);
+std::shared_ptr<const TurtlePath> FractalDrawer::compile(const LSystemGenerator& generator, int iterations, double startDirection,
+    double angleIncrement, float stepLength, bool treeStyle) {
+    auto path = std::make_shared<TurtlePath>();
+    walk(generator, iterations, startDirection, angleIncrement, stepLength, treeStyle, [&](const TurtleSegment& segment) {
+        path->segments.push_back(segment);
+        extendBounds(*path, segment.to);
+    });
+    return path;
+}
 
-    currentPosition = PointF(0, 0);
-    currentDirection = currentLSystem->startDirection;
-    minX = minY = maxX = maxY = 0.0;
+// Points are passed to OpenCV in fixed point with this many fractional bits.
+const int SHIFT = 4;
 
-    calculateBounds(sequence, angleIncrement, stepLength, 0.0f);
+bool FractalDrawer::fit(const TurtlePath& bounds) {
+    const double MARGIN = 20;
 
-    double width = maxX - minX;
-    double height = maxY - minY;
+    canvas = cv::Scalar(255, 255, 255);
 
-    if (width == 0 || height == 0) {
+    double width = bounds.maxX - bounds.minX;
+    double height = bounds.maxY - bounds.minY;
+    if (width == 0 && height == 0) {
         printf("Error: Zero bounds\n");
-        return;
+        return false;
     }
 
-    double scaleX = (CANVAS_WIDTH - 40) / width;
-    double scaleY = (CANVAS_HEIGHT - 40) / height;
-    scaleCoef = std::min(scaleX, scaleY);
+    double scaleX = width > 0 ? (canvas.cols - 2 * MARGIN) / width : DBL_MAX;
+    double scaleY = height > 0 ? (canvas.rows - 2 * MARGIN) / height : DBL_MAX;
+    scale = std::min(scaleX, scaleY) * (1 << SHIFT);
+    offsetX = ((canvas.cols - width * scale / (1 << SHIFT)) / 2) * (1 << SHIFT) - bounds.minX * scale;
+    offsetY = ((canvas.rows - height * scale / (1 << SHIFT)) / 2) * (1 << SHIFT) - bounds.minY * scale;
+    return true;
+}
 
-    double offsetX = (CANVAS_WIDTH - width * scaleCoef) / 2 - minX * scaleCoef;
-    double offsetY = (CANVAS_HEIGHT - height * scaleCoef) / 2 - minY * scaleCoef;
+void FractalDrawer::drawSegments(const TurtleSegment* segments, size_t count, size_t firstStep) {
+    auto toCanvas = [&](const PointF& p) {
+        return cv::Point(cvRound(p.x * scale + offsetX), cvRound(p.y * scale + offsetY));
+    };
 
-    currentPosition = PointF(static_cast<float>(offsetX), static_cast<float>(offsetY));
-    currentDirection = currentLSystem->startDirection;
+    // Connected segments of one style form a polyline; polylines of one style go to OpenCV at once.
+    std::vector<cv::Point> points;
+    std::vector<int> counts;
+    std::vector<const cv::Point*> starts;
+    int color = -1, thickness = -1;
+
+    auto flush = [&]() {
+        if (counts.empty()) return;
+        starts.clear();
+        size_t offset = 0;
+        for (int count : counts) {
+            starts.push_back(points.data() + offset);
+            offset += count;
+        }
+        cv::polylines(canvas, starts.data(), counts.data(), static_cast<int>(counts.size()), false,
+            cv::Scalar(color, color, color), thickness, cv::LINE_8, SHIFT);
+        points.clear();
+        counts.clear();
+    };
 
-    std::stack<std::tuple<PointF, double, float, int, float>> stack;
-    PointF currentPos = currentPosition;
-    double currentDir = currentDirection;
-    float currentStep = stepLength * static_cast<float>(scaleCoef);
+    for (size_t i = 0; i < count; i++) {
+        const TurtleSegment& segment = segments[i];
+        cv::Point from = toCanvas(segment.from);
+        cv::Point to = toCanvas(segment.to);
+        int segmentThickness = std::max(1, static_cast<int>(segment.thickness));
 
-    int currentColor = 0;
-    float currentThickness = 2.0f;
+        if (segment.color != color || segmentThickness != thickness) {
+            flush();
+            color = segment.color;
+            thickness = segmentThickness;
+        }
+        if (counts.empty() || points.back() != from) {
+            points.push_back(from);
+            counts.push_back(1);
+        }
+        points.push_back(to);
+        counts.back()++;
 
-    if (selectedLSystem == 3) {
-        currentPosition = PointF(CANVAS_WIDTH / 2, CANVAS_HEIGHT - 50); 
-        currentPos = currentPosition;
-        currentDirection = 90; 
-        currentThickness = 15.0f; 
-        currentColor = 80;
+        if ((i & 0xFFFF) == 0) {
+            current_draw_step = static_cast<int>(std::min<size_t>(firstStep + i, INT_MAX));
+        }
     }
+    flush();
+}
 
-    int branchDepth = 0;
-    const int MAX_DEPTH = 8;
-
-    for (char symbol : sequence) {
-        if (isalpha(symbol)) {
-            if (selectedLSystem == 3) {
-                currentThickness = std::max(2.0f, 15.0f - branchDepth * 1.8f);
-
-                if (branchDepth < 2) {
-                    currentColor = 80 - branchDepth * 10;
-                }
-                else {
-                    currentColor = std::min(150, 60 + branchDepth * 15);
-                }
+void FractalDrawer::render(const TurtlePath& path) {
+    if (!fit(path)) {
+        return;
+    }
+    total_draw_steps = static_cast<int>(std::min<size_t>(path.segments.size(), INT_MAX));
+    drawSegments(path.segments.data(), path.segments.size(), 0);
+    current_draw_step = total_draw_steps;
+}
 
-                currentStep *= 0.92f;
-            }
+void FractalDrawer::draw(const LSystemGenerator& generator, int iterations, double startDirection, double angleIncrement,
+    float stepLength, bool treeStyle, size_t chunkSize) {
+    TurtlePath bounds;
+    size_t segmentCount = 0;
+    current_draw_step = total_draw_steps = 0;
+    walk(generator, iterations, startDirection, angleIncrement, stepLength, treeStyle, [&](const TurtleSegment& segment) {
+        extendBounds(bounds, segment.to);
+        segmentCount++;
+    });
+    if (!fit(bounds)) {
+        return;
+    }
 
-            PointF nextPos = calculateNextPosition(currentStep, currentPos, currentDir);
-            drawLine(currentPos, nextPos, currentColor, currentThickness);
-            currentPos = nextPos;
+    total_draw_steps = static_cast<int>(std::min<size_t>(segmentCount, INT_MAX));
+    std::vector<TurtleSegment> chunk;
+    chunk.reserve(chunkSize);
+    size_t drawn = 0;
+    auto drawChunk = [&]() {
+        drawSegments(chunk.data(), chunk.size(), drawn);
+        drawn += chunk.size();
+        chunk.clear();
+    };
+    walk(generator, iterations, startDirection, angleIncrement, stepLength, treeStyle, [&](const TurtleSegment& segment) {
+        chunk.push_back(segment);
+        if (chunk.size() == chunkSize) {
+            drawChunk();
         }
-        else {
-            switch (symbol) {
-            case '+':
-                currentDir += angleIncrement;
-                break;
-            case '-':
-                currentDir -= angleIncrement;
-                break;
-            case '[':
-                stack.push(std::make_tuple(currentPos, currentDir, currentStep, currentColor, currentThickness));
-                if (selectedLSystem == 3) {
-                    branchDepth++;
-                }
-                break;
-            case ']':
-                if (!stack.empty()) {
-                    auto savedState = stack.top();
-                    stack.pop();
-                    currentPos = std::get<0>(savedState);
-                    currentDir = std::get<1>(savedState);
-                    currentStep = std::get<2>(savedState);
-                    currentColor = std::get<3>(savedState);
-                    currentThickness = std::get<4>(savedState);
-                    if (selectedLSystem == 3) {
-                        branchDepth--;
-                    }
-                }
-                break;
-            case '@':
-                if (!randomAngles.empty()) {
-                    angleIncrement = randomAngles.front();
-                    randomAngles.pop();
-                }
-                break;
-            }
+    });
+    drawChunk();
+    current_draw_step = total_draw_steps;
+}
+
+bool usesRandomAngles(const LSystem& lSystem) {
+    if (lSystem.axiom.find('@') != std::string::npos) {
+        return true;
+    }
+    for (const auto& rule : lSystem.rules) {
+        if (rule.second.find('@') != std::string::npos) {
+            return true;
         }
     }
-
-    printf("Draw completed\n");
-    lsystem_running = false;
+    return false;
 }
 
 void loadLSystem(const std::string& filename) {
@@ -377,8 +608,8 @@ void loadLSystem(const std::string& filename) {
         printf("Loading L-system from: %s\n", fullPath.c_str());
         currentLSystem = std::make_shared<LSystem>(fullPath);
         currentGenerator = std::make_shared<LSystemGenerator>(currentLSystem);
-        currentSequence = currentGenerator->generateSequence(currentIterations);
-        printf("Generated sequence length: %zu\n", currentSequence.length());
+        currentFileHash = hashFile(fullPath);
+        printf("Sequence length: %llu\n", (unsigned long long)currentGenerator->sequenceLength(currentIterations));
         needsRedraw = true;
     }
     catch (const std::exception& e) {
@@ -404,7 +635,25 @@ void drawLSystemDemo() {
 
     if (ImGui::SliderInt("Iterations", &currentIterations, 1, 15)) {
         if (currentGenerator) {
-            currentSequence = currentGenerator->generateSequence(currentIterations);
+            needsRedraw = true;
+        }
+    }
+
+    if (ImGui::SliderInt2("Canvas Size", lsystemCanvasSize, 200, 1600)) {
+        canvasResizePending = true;
+    }
+    if (canvasResizePending && !lsystem_running) {
+        canvasResizePending = false;
+        lsystemCanvas = cv::Mat(lsystemCanvasSize[1], lsystemCanvasSize[0], CV_8UC3, cv::Scalar(255, 255, 255));
+        std::shared_ptr<const TurtlePath> path;
+        {
+            std::lock_guard<std::mutex> lock(pathMutex);
+            path = currentPath;
+        }
+        if (path) {
+            FractalDrawer(lsystemCanvas).render(*path);
+        }
+        else if (currentGenerator && lsystemDrawn) {
             needsRedraw = true;
         }
     }
@@ -412,30 +661,118 @@ void drawLSystemDemo() {
     if (ImGui::Button("Draw Fractal") || needsRedraw) {
         if (currentGenerator && currentLSystem && !lsystem_running) {
             printf("=== DRAWING FRACTAL ===\n");
-            currentSequence = currentGenerator->generateSequence(currentIterations);
             lsystem_running = true;
 
-            std::thread([&]() {
-                FractalDrawer drawer(lsystemCanvas);
-                float stepLen = (selectedLSystem == 3) ? 25.0f : 10.0f;
-                drawer.draw(currentSequence, currentLSystem->angle, stepLen);
+            bool treeStyle = (selectedLSystem == 3);
+            unsigned int seed = usesRandomAngles(*currentLSystem) ? lsystemSeed : 0;
+            std::thread([generator = currentGenerator, lSystem = currentLSystem, iterations = currentIterations,
+                fileHash = currentFileHash, treeStyle, seed]() {
+                printf("Starting draw: sequence length=%llu\n", (unsigned long long)generator->sequenceLength(iterations));
+                FractalDrawer drawer(lsystemCanvas, seed);
+                float stepLen = treeStyle ? 25.0f : 10.0f;
+                auto path = lsystemCache.findPath(fileHash, iterations, seed);
+                if (path) {
+                    printf("Using cached path\n");
+                }
+                else if (generator->sequenceLength(iterations) <= PATH_LIMIT) {
+                    path = drawer.compile(*generator, iterations, lSystem->startDirection, lSystem->angle, stepLen, treeStyle);
+                    lsystemCache.putPath(fileHash, iterations, seed, path);
+                }
+                if (path) {
+                    drawer.render(*path);
+                }
+                else {
+                    drawer.draw(*generator, iterations, lSystem->startDirection, lSystem->angle, stepLen, treeStyle);
+                }
+                {
+                    std::lock_guard<std::mutex> lock(pathMutex);
+                    currentPath = path;
+                }
+                printf("Draw completed: %d segments\n", total_draw_steps);
+                lsystemDrawn = true;
+                lsystem_running = false;
                 }).detach();
 
             needsRedraw = false;
         }
     }
 
+    ImGui::SameLine();
+    if (ImGui::Button("New Seed")) {
+        lsystemSeed = std::random_device{}();
+        needsRedraw = true;
+    }
+
     if (lsystem_running) {
         ImGui::SameLine();
         ImGui::Text("Drawing... %d/%d", current_draw_step, total_draw_steps);
     }
 
+    if (ImGui::SliderInt("Cache Budget (MB)", &cacheBudgetMb, 16, 4096)) {
+        lsystemCache.setBudget(size_t(cacheBudgetMb) << 20);
+    }
+    ImGui::Text("Cache: %zu entries, %.1f MB", lsystemCache.size(), lsystemCache.memory() / 1048576.0);
+
+    if (ImGui::Button("Export Sequence") && currentGenerator && !exportRunning) {
+        uint64_t length = currentGenerator->sequenceLength(currentIterations);
+        if (length > EXPORT_LIMIT) {
+            std::lock_guard<std::mutex> lock(exportMutex);
+            exportStatus = "Sequence is too long to export";
+            printf("%s\n", exportStatus.c_str());
+        }
+        else {
+            std::string path = std::filesystem::path(lSystemFiles[selectedLSystem]).stem().string() +
+                "_" + std::to_string(currentIterations) + ".txt";
+            exportRunning = true;
+            exportWritten = 0;
+            exportTotal = length;
+            std::thread([generator = currentGenerator, fileHash = currentFileHash, iterations = currentIterations, path]() {
+                // Written in pieces so the UI can show how far the file got.
+                const size_t CHUNK = size_t(16) << 20;
+
+                auto start = std::chrono::steady_clock::now();
+                auto sequence = lsystemCache.sequence(*generator, fileHash, iterations);
+                std::ofstream file(path, std::ios::binary);
+                for (size_t offset = 0; offset < sequence->size() && file; offset += CHUNK) {
+                    size_t count = std::min(CHUNK, sequence->size() - offset);
+                    file.write(sequence->data() + offset, count);
+                    exportWritten = offset + count;
+                }
+                file.close();
+                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+                {
+                    std::lock_guard<std::mutex> lock(exportMutex);
+                    exportStatus = file ? "Saved " + path + " (" + std::to_string(elapsed.count()) + " ms)"
+                        : "Cannot write " + path;
+                    printf("%s\n", exportStatus.c_str());
+                }
+                exportRunning = false;
+                }).detach();
+        }
+    }
+    if (exportRunning) {
+        ImGui::SameLine();
+        if (exportWritten == 0) {
+            ImGui::Text("Exporting: expanding the sequence...");
+        }
+        else {
+            ImGui::Text("Exporting: %.1f / %.1f MB", exportWritten / 1048576.0, exportTotal / 1048576.0);
+        }
+    }
+    else {
+        std::lock_guard<std::mutex> lock(exportMutex);
+        if (!exportStatus.empty()) {
+            ImGui::SameLine();
+            ImGui::Text("%s", exportStatus.c_str());
+        }
+    }
+
     if (currentLSystem) {
         ImGui::Separator();
         ImGui::Text("Axiom: %s", currentLSystem->axiom.c_str());
         ImGui::Text("Angle: %.1f", currentLSystem->angle);
         ImGui::Text("Start Direction: %.1f", currentLSystem->startDirection);
-        ImGui::Text("Sequence length: %zu", currentSequence.length());
+        ImGui::Text("Sequence length: %llu", (unsigned long long)currentGenerator->sequenceLength(currentIterations));
         ImGui::Text("Rules:");
         for (const auto& rule : currentLSystem->rules) {
             ImGui::Text("  %c -> %s", rule.first, rule.second.c_str());
@@ -5,8 +5,8 @@
 #include <unordered_map>
 #include <memory>
 #include <random>
-#include <stack>
-#include <queue>
+#include <cstdint>
+#include <array>
 #include <opencv2/opencv.hpp>
 
 namespace Lab05 {
@@ -34,27 +34,77 @@ namespace Lab05 {
     public:
         LSystemGenerator(std::shared_ptr<LSystem> lsystem);
         std::string generateSequence(int iterations);
+
+        // Length of generateSequence(iterations) without expanding it; saturates at UINT64_MAX.
+        uint64_t sequenceLength(int iterations) const;
+
+        // Calls visit(symbol) for every symbol of generateSequence(iterations), in order. The rewrite
+        // tree is walked depth-first with one frame per iteration, so memory does not depend on the
+        // length of the sequence.
+        template<class Visitor>
+        void expand(int iterations, Visitor&& visit) const;
+
+        // Same result as generateSequence(iterations), built in parallel. The expanded length of every
+        // symbol at every depth gives each subtree its offset in one preallocated string, and threads
+        // fill disjoint ranges of it. threadCount = 0 uses all hardware threads.
+        std::string expandParallel(int iterations, unsigned int threadCount = 0) const;
+
+        // Rewrites start the given number of times; with start = generateSequence(k) this gives
+        // generateSequence(k + iterations).
+        std::string expandParallel(const std::string& start, int iterations, unsigned int threadCount = 0) const;
+    };
+
+    struct TurtleSegment {
+        PointF from, to;
+        float thickness;
+        uint16_t depth;     // nesting level of '[' brackets
+        uint8_t color;      // gray level
+    };
+
+    // One interpretation of a sequence by the turtle, in L-system units (one step = stepLength).
+    struct TurtlePath {
+        std::vector<TurtleSegment> segments;
+        double minX = 0, maxX = 0, minY = 0, maxY = 0;
     };
 
     class FractalDrawer {
     private:
         cv::Mat canvas;
-        PointF currentPosition;
-        double currentDirection;
-        double minX, maxX, minY, maxY;
-        double scaleCoef;
-
-        std::stack<std::tuple<PointF, double, float, int, float>> stateStack;
-        std::queue<double> randomAngles;
+        // Reseeded before each compile, so '@' draws the same angles for the same drawer.
+        unsigned int randomSeed;
         std::mt19937 rng;
+        // Canvas transform of the last fit(), in fixed point.
+        double scale = 0, offsetX = 0, offsetY = 0;
+
+        // Runs the turtle over generator.expand(iterations) and passes every line to emit(segment).
+        template<class Emit>
+        void walk(const LSystemGenerator& generator, int iterations, double startDirection, double angleIncrement,
+            float stepLength, bool treeStyle, Emit&& emit);
+
+        // Clears the canvas and fits the bounds of path into it; false if the bounds are empty.
+        bool fit(const TurtlePath& bounds);
+        // Draws segments with the transform of fit() as polylines, batched while the style stays the same.
+        // firstStep is the number of the first segment for the progress counter.
+        void drawSegments(const TurtleSegment* segments, size_t count, size_t firstStep);
 
     public:
-        FractalDrawer(cv::Mat targetCanvas);
+        FractalDrawer(cv::Mat targetCanvas, unsigned int seed = std::random_device{}());
 
         PointF calculateNextPosition(float stepLength, PointF position, double direction);
-        void drawLine(const PointF& p1, const PointF& p2, int colorValue, float thickness);
-        void calculateBounds(const std::string& sequence, double angleIncrement, float stepLength, float stepDecreasePercent = 0.0f);
-        void draw(const std::string& sequence, double angleIncrement, float stepLength);
+
+        // Runs the turtle over the sequence once and records every line with its style and the bounds.
+        // treeStyle grows the trunk upward with thickness and color depending on the branch depth.
+        std::shared_ptr<const TurtlePath> compile(const LSystemGenerator& generator, int iterations, double startDirection,
+            double angleIncrement, float stepLength, bool treeStyle);
+
+        // Fits the path into the canvas and draws it. Needs no access to the sequence, so a new canvas size
+        // only costs this call.
+        void render(const TurtlePath& path);
+
+        // Draws the fractal without keeping its path, for sequences whose path would not fit in memory:
+        // one walk finds the bounds, a second one draws the segments in chunks of chunkSize.
+        void draw(const LSystemGenerator& generator, int iterations, double startDirection, double angleIncrement,
+            float stepLength, bool treeStyle, size_t chunkSize = size_t(1) << 16);
     };
 
     class App {
@@ -62,4 +112,39 @@ namespace Lab05 {
         int run();
     };
 
+    template<class Visitor>
+    void LSystemGenerator::expand(int iterations, Visitor&& visit) const {
+        // Symbols without a rule (or with an identity rule like F>F) are emitted at once.
+        const std::string* rule[256] = {};
+        for (const auto& r : lSystem->rules) {
+            if (r.second.size() != 1 || r.second[0] != r.first) {
+                rule[(unsigned char)r.first] = &r.second;
+            }
+        }
+
+        struct Frame {
+            const std::string* text;
+            size_t pos;
+            int level;
+        };
+        std::vector<Frame> stack;
+        stack.reserve(iterations + 1);
+        stack.push_back({ &lSystem->axiom, 0, 0 });
+        while (!stack.empty()) {
+            Frame& top = stack.back();
+            if (top.pos == top.text->size()) {
+                stack.pop_back();
+                continue;
+            }
+            char symbol = (*top.text)[top.pos++];
+            const std::string* replacement = rule[(unsigned char)symbol];
+            if (replacement && top.level < iterations) {
+                stack.push_back({ replacement, 0, top.level + 1 });
+            }
+            else {
+                visit(symbol);
+            }
+        }
+    }
+
 }
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "LSystemCache.h"
+
+#include <fstream>
+
+namespace Lab05 {
+
+    uint64_t hashFile(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return 0;
+        }
+
+        uint64_t hash = 14695981039346656037ull;
+        char buffer[4096];
+        while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+            for (std::streamsize i = 0; i < file.gcount(); i++) {
+                hash = (hash ^ (unsigned char)buffer[i]) * 1099511628211ull;
+            }
+        }
+        return hash;
+    }
+
+    size_t LSystemCache::KeyHash::operator()(const Key& key) const {
+        uint64_t hash = key.fileHash;
+        hash = (hash ^ (uint64_t)key.iterations) * 1099511628211ull;
+        hash = (hash ^ key.seed) * 1099511628211ull;
+        hash = (hash ^ (uint64_t)key.kind) * 1099511628211ull;
+        return (size_t)hash;
+    }
+
+    LSystemCache::LSystemCache(size_t budgetBytes) : budget(budgetBytes) {
+    }
+
+    std::shared_ptr<const std::string> LSystemCache::sequence(const LSystemGenerator& generator, uint64_t fileHash, int iterations) {
+        // Rewriting a cached level costs about as much per symbol of it as expanding from the axiom
+        // costs per 64 output symbols, so shorter levels are not worth starting from.
+        const uint64_t MIN_GROWTH = 64;
+
+        std::shared_ptr<const std::string> start;
+        int startLevel = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (const Entry* entry = find({ fileHash, iterations, 0, SEQUENCE })) {
+                return entry->sequence;
+            }
+            uint64_t length = generator.sequenceLength(iterations);
+            for (int level = iterations - 1; level > 0; level--) {
+                const Entry* entry = peek({ fileHash, level, 0, SEQUENCE });
+                if (entry && entry->sequence->size() * MIN_GROWTH <= length) {
+                    start = entry->sequence;
+                    startLevel = level;
+                    find(entry->key);
+                    break;
+                }
+            }
+        }
+
+        auto result = std::make_shared<const std::string>(start
+            ? generator.expandParallel(*start, iterations - startLevel)
+            : generator.expandParallel(iterations));
+
+        std::lock_guard<std::mutex> lock(mutex);
+        put({ { fileHash, iterations, 0, SEQUENCE }, result, nullptr, result->capacity() + sizeof(std::string) });
+        return result;
+    }
+
+    std::shared_ptr<const TurtlePath> LSystemCache::findPath(uint64_t fileHash, int iterations, unsigned int seed) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const Entry* entry = find({ fileHash, iterations, seed, PATH });
+        return entry ? entry->path : nullptr;
+    }
+
+    void LSystemCache::putPath(uint64_t fileHash, int iterations, unsigned int seed, std::shared_ptr<const TurtlePath> path) {
+        size_t bytes = path->segments.capacity() * sizeof(TurtleSegment) + sizeof(TurtlePath);
+        std::lock_guard<std::mutex> lock(mutex);
+        put({ { fileHash, iterations, seed, PATH }, nullptr, std::move(path), bytes });
+    }
+
+    void LSystemCache::setBudget(size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        budget = bytes;
+        trim();
+    }
+
+    size_t LSystemCache::memory() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return usedBytes;
+    }
+
+    size_t LSystemCache::size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+    const LSystemCache::Entry* LSystemCache::find(const Key& key) {
+        auto it = index.find(key);
+        if (it == index.end()) {
+            return nullptr;
+        }
+        entries.splice(entries.begin(), entries, it->second);
+        return &entries.front();
+    }
+
+    const LSystemCache::Entry* LSystemCache::peek(const Key& key) const {
+        auto it = index.find(key);
+        return it == index.end() ? nullptr : &*it->second;
+    }
+
+    void LSystemCache::put(Entry entry) {
+        // An entry larger than the whole budget would only flush everything else.
+        if (entry.bytes > budget) {
+            return;
+        }
+        auto it = index.find(entry.key);
+        if (it != index.end()) {
+            usedBytes -= it->second->bytes;
+            entries.erase(it->second);
+        }
+        usedBytes += entry.bytes;
+        entries.push_front(std::move(entry));
+        index[entries.front().key] = entries.begin();
+        trim();
+    }
+
+    void LSystemCache::trim() {
+        while (usedBytes > budget && !entries.empty()) {
+            usedBytes -= entries.back().bytes;
+            index.erase(entries.back().key);
+            entries.pop_back();
+        }
+    }
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "App.h"
+
+namespace Lab05 {
+
+    // FNV-1a hash of the contents of a file, 0 if it cannot be read.
+    uint64_t hashFile(const std::string& path);
+
+    // Expanded sequences (for export) and compiled turtle paths, keyed by the hash of the L-system file,
+    // the number of iterations and the random seed. When the entries take more than the budget, the least
+    // recently used ones are dropped. Shared by the UI and the drawing thread.
+    class LSystemCache {
+    public:
+        explicit LSystemCache(size_t budgetBytes = size_t(256) << 20);
+
+        // generateSequence(iterations), cached. On a miss the sequence is built from the deepest cached
+        // level that saves work, otherwise from the axiom.
+        std::shared_ptr<const std::string> sequence(const LSystemGenerator& generator, uint64_t fileHash, int iterations);
+
+        std::shared_ptr<const TurtlePath> findPath(uint64_t fileHash, int iterations, unsigned int seed);
+        void putPath(uint64_t fileHash, int iterations, unsigned int seed, std::shared_ptr<const TurtlePath> path);
+
+        void setBudget(size_t bytes);
+        size_t memory() const;
+        size_t size() const;
+
+    private:
+        enum Kind {
+            SEQUENCE,
+            PATH
+        };
+
+        struct Key {
+            uint64_t fileHash;
+            int iterations;
+            unsigned int seed;
+            Kind kind;
+
+            bool operator==(const Key& other) const = default;
+        };
+
+        struct KeyHash {
+            size_t operator()(const Key& key) const;
+        };
+
+        struct Entry {
+            Key key;
+            std::shared_ptr<const std::string> sequence;
+            std::shared_ptr<const TurtlePath> path;
+            size_t bytes;
+        };
+
+        // The caller holds the mutex. find() marks the entry as most recently used, peek() leaves the order alone.
+        const Entry* find(const Key& key);
+        const Entry* peek(const Key& key) const;
+        void put(Entry entry);
+        void trim();
+
+        mutable std::mutex mutex;
+        size_t budget;
+        size_t usedBytes = 0;
+        std::list<Entry> entries;   // most recently used first
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+    };
+
+}
@@ -0,0 +1,39 @@
+#include "Affine.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AFFINE_SSE2 1
+#else
+#define AFFINE_SSE2 0
+#endif
+
+namespace Lab04 {
+
+    void transformPoints(const Affine2D& m, cv::Point* points, size_t count) {
+        size_t i = 0;
+#if AFFINE_SSE2
+        // A point is a (x, y) pair of doubles; both output coordinates come out of one multiply-add chain:
+        // (x', y') = (a, d) * x + (b, e) * y + (c, f). _mm_cvtpd_epi32 rounds to nearest even, like cvRound.
+        static_assert(sizeof(cv::Point) == 2 * sizeof(int), "cv::Point must be two packed ints");
+        const __m128d col0 = _mm_setr_pd(m.a, m.d);
+        const __m128d col1 = _mm_setr_pd(m.b, m.e);
+        const __m128d col2 = _mm_setr_pd(m.c, m.f);
+        int* data = reinterpret_cast<int*>(points);
+        for (; i + 2 <= count; i += 2) {
+            __m128i xy = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 2 * i));
+            __m128d p0 = _mm_cvtepi32_pd(xy);
+            __m128d p1 = _mm_cvtepi32_pd(_mm_srli_si128(xy, 8));
+            __m128d r0 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(col0, _mm_unpacklo_pd(p0, p0)),
+                _mm_mul_pd(col1, _mm_unpackhi_pd(p0, p0))), col2);
+            __m128d r1 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(col0, _mm_unpacklo_pd(p1, p1)),
+                _mm_mul_pd(col1, _mm_unpackhi_pd(p1, p1))), col2);
+            __m128i out = _mm_unpacklo_epi64(_mm_cvtpd_epi32(r0), _mm_cvtpd_epi32(r1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + 2 * i), out);
+        }
+#endif
+        for (; i < count; ++i) {
+            points[i] = m.apply(points[i]);
+        }
+    }
+
+}
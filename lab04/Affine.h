@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../provider.h"
+
+namespace Lab04 {
+
+    // Affine map of the plane stored as the top two rows of a 3x3 matrix (the third row is 0 0 1):
+    //   x' = a * x + b * y + c
+    //   y' = d * x + e * y + f
+    struct Affine2D {
+        double a = 1, b = 0, c = 0;
+        double d = 0, e = 1, f = 0;
+
+        static constexpr Affine2D identity() {
+            return {};
+        }
+
+        static constexpr Affine2D translation(double dx, double dy) {
+            return { 1, 0, dx, 0, 1, dy };
+        }
+
+        static constexpr Affine2D scaling(double sx, double sy) {
+            return { sx, 0, 0, 0, sy, 0 };
+        }
+
+        // Counter-clockwise in math axes, i.e. clockwise on screen where y points down.
+        static constexpr Affine2D rotation(double cosA, double sinA) {
+            return { cosA, -sinA, 0, sinA, cosA, 0 };
+        }
+
+        static Affine2D rotation(double angleRad) {
+            return rotation(std::cos(angleRad), std::sin(angleRad));
+        }
+
+        // m applied with (cx, cy) as the origin.
+        static constexpr Affine2D around(double cx, double cy, const Affine2D& m) {
+            return translation(cx, cy) * m * translation(-cx, -cy);
+        }
+
+        // (*this * o)(p) == (*this)(o(p)): o is applied first.
+        constexpr Affine2D operator*(const Affine2D& o) const {
+            return { a * o.a + b * o.d, a * o.b + b * o.e, a * o.c + b * o.f + c,
+                     d * o.a + e * o.d, d * o.b + e * o.e, d * o.c + e * o.f + f };
+        }
+
+        constexpr double determinant() const {
+            return a * e - b * d;
+        }
+
+        cv::Point2d operator()(double x, double y) const {
+            return cv::Point2d(a * x + b * y + c, d * x + e * y + f);
+        }
+
+        // Rounded the same way cv::Point2d converts to cv::Point (cvRound).
+        cv::Point apply(const cv::Point& p) const {
+            cv::Point2d q = (*this)(p.x, p.y);
+            return cv::Point(cvRound(q.x), cvRound(q.y));
+        }
+    };
+
+    // Transforms count points in place, two at a time with SSE2 where available.
+    void transformPoints(const Affine2D& m, cv::Point* points, size_t count);
+
+    inline void transformPoints(const Affine2D& m, vector<cv::Point>& points) {
+        transformPoints(m, points.data(), points.size());
+    }
+
+}
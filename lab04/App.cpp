@@ -1,5 +1,14 @@
 #include "../provider.h"
 #include "App.h"
+#include "Affine.h"
+#include "PolygonIndex.h"
+#include "Intersections.h"
+#include "LooseQuadtree.h"
+#include "Triangulation.h"
+#include "ScanlineFill.h"
+
+#include <chrono>
+#include <random>
 
 namespace Lab04 {
     static double EPS = 0.0001;
@@ -16,6 +25,7 @@ namespace Lab04 {
     float rotationAngle = 0.0f;
     float scaleX = 1.0f;
     float scaleY = 1.0f;
+    bool transformAllPolygons = false;
 
     int currentSearch = 0;
     cv::Point clickedPointForSearch = cv::Point(-1, -1);
@@ -25,6 +35,31 @@ namespace Lab04 {
     bool isDeterminingPointPosition = false;
     bool isCheckingPointInPolygon = false;
 
+    // The canvas is composed from two layers: polygonLayer (background and polygon outlines) and the
+    // overlay (search points, intersection edge and points) drawn on top. Edits report the rectangles
+    // they touch; before the canvas is shown only those regions are re-rendered and recomposed, and
+    // only polygons whose bounds intersect them are drawn.
+    cv::Mat polygonLayer;
+    vector<cv::Rect> polygonBounds;
+    vector<cv::Rect> layerDirty;
+    vector<cv::Rect> canvasDirty;
+
+    // Triangulation per polygon, dropped whenever the polygon changes and rebuilt when it is filled.
+    // Polygons that are not simple have none and are filled from the outline by the even-odd rule.
+    struct PolygonFill {
+        bool valid = false;
+        bool triangulated = false;
+        vector<cv::Vec3i> triangles;
+    };
+    vector<PolygonFill> polygonFills;
+    bool fillPolygons = false;
+
+    // Polygon bounds by polygon index, for picking and for finding what a dirty rectangle has to redraw.
+    LooseQuadtree polygonTree;
+
+    // All polygon edges, keyed by edgeKey, for intersection queries of a single new edge.
+    SegmentGrid edgeGrid;
+
     void drawPoint(cv::Mat& img, cv::Point p, cv::Scalar color, int radius = 3) {
         cv::circle(img, p, radius, color, -1);
     }
@@ -33,38 +68,186 @@ namespace Lab04 {
         cv::line(img, p1, p2, color, thickness, cv::LINE_AA);
     }
 
+    cv::Rect pointBounds(cv::Point2f p, int radius) {
+        int r = radius + 2;
+        return cv::Rect((int)std::floor(p.x) - r, (int)std::floor(p.y) - r, 2 * r + 2, 2 * r + 2);
+    }
+
+    // Anti-aliased 1px lines spill one pixel around the exact segment.
+    cv::Rect segmentBounds(cv::Point p1, cv::Point p2) {
+        return cv::Rect(std::min(p1.x, p2.x) - 2, std::min(p1.y, p2.y) - 2,
+            std::abs(p1.x - p2.x) + 5, std::abs(p1.y - p2.y) + 5);
+    }
+
+    void updatePolygonBounds(size_t i) {
+        const auto& poly = polygons[i];
+        polygonBounds.resize(polygons.size());
+        polygonFills.resize(polygons.size());
+        polygonFills[i] = PolygonFill();
+        if (poly.empty()) {
+            polygonBounds[i] = cv::Rect();
+            polygonTree.remove((int)i);
+            return;
+        }
+        cv::Rect r = cv::boundingRect(poly);
+        polygonBounds[i] = cv::Rect(r.x - 2, r.y - 2, r.width + 4, r.height + 4);
+        polygonTree.update((int)i, polygonBounds[i]);
+    }
+
+    long long edgeKey(size_t polygon, size_t edge) {
+        return ((long long)polygon << 32) | (long long)edge;
+    }
+
+    // Edge j joins vertex j with the next one; appending a vertex only changes the last two edges.
+    void updatePolygonEdges(size_t i, size_t from = 0) {
+        const auto& poly = polygons[i];
+        for (size_t j = from; j < poly.size(); ++j) {
+            edgeGrid.insert(edgeKey(i, j), poly[j], poly[(j + 1) % poly.size()]);
+        }
+    }
+
+    void invalidateCanvas(const cv::Rect& r) {
+        cv::Rect clipped = r & cv::Rect(0, 0, canvas.cols, canvas.rows);
+        if (clipped.area() > 0) {
+            canvasDirty.push_back(clipped);
+        }
+    }
+
+    void invalidateLayer(const cv::Rect& r) {
+        cv::Rect clipped = r & cv::Rect(0, 0, canvas.cols, canvas.rows);
+        if (clipped.area() > 0) {
+            layerDirty.push_back(clipped);
+            canvasDirty.push_back(clipped);
+        }
+    }
+
+    // Everything the overlay currently draws; called before and after an overlay change.
+    void invalidateOverlay() {
+        for (const auto& pt : intersectionPoints) {
+            invalidateCanvas(pointBounds(pt, 5));
+        }
+        if (clickedPointForSearch.x != -1) {
+            invalidateCanvas(pointBounds(clickedPointForSearch, 3));
+        }
+        if (!intersectionEdgePoints.empty()) {
+            invalidateCanvas(pointBounds(intersectionEdgePoints[0], 3));
+        }
+        if (intersectionEdgePoints.size() == 2) {
+            invalidateCanvas(segmentBounds(intersectionEdgePoints[0], intersectionEdgePoints[1]));
+        }
+    }
+
     void redrawScene() {
-        canvas = cv::Mat(canvas.size(), CV_8UC3, cv::Scalar(255, 255, 255));
-        for (size_t i = 0; i < polygons.size(); ++i) {
+        invalidateLayer(cv::Rect(0, 0, canvas.cols, canvas.rows));
+    }
+
+    void fillCachedPolygon(cv::Mat& img, size_t i, cv::Point offset) {
+        polygonFills.resize(polygons.size());
+        PolygonFill& fill = polygonFills[i];
+        if (!fill.valid) {
+            fill.triangulated = triangulatePolygon(polygons[i], fill.triangles);
+            fill.valid = true;
+        }
+        // Lighter than the outline so that it stays visible.
+        const cv::Scalar& c = polygonColors[i];
+        cv::Scalar color((c[0] + 255) / 2, (c[1] + 255) / 2, (c[2] + 255) / 2);
+        if (fill.triangulated) {
+            fillTriangles(img, polygons[i], fill.triangles, color, offset);
+        }
+        else {
+            fillPolygon(img, polygons[i], color, offset);
+        }
+    }
+
+    void renderPolygons(const cv::Rect& roi) {
+        cv::Mat view = polygonLayer(roi);
+        view.setTo(cv::Scalar(255, 255, 255));
+        cv::Point offset = roi.tl();
+        // Later polygons are drawn over earlier ones.
+        vector<int> visible;
+        polygonTree.query(roi, [&](int i) { visible.push_back(i); });
+        std::sort(visible.begin(), visible.end());
+        for (int i : visible) {
+            if (fillPolygons) {
+                fillCachedPolygon(view, i, offset);
+            }
             const auto& poly = polygons[i];
             const auto& color = polygonColors[i];
             for (size_t j = 0; j < poly.size(); ++j) {
-                drawLine(canvas, poly[j], poly[(j + 1) % poly.size()], color);
+                drawLine(view, poly[j] - offset, poly[(j + 1) % poly.size()] - offset, color);
             }
         }
+    }
 
+    void renderOverlay(const cv::Rect& roi) {
+        cv::Mat view = canvas(roi);
+        cv::Point2f offset((float)roi.x, (float)roi.y);
         for (const auto& pt : intersectionPoints) {
-            drawPoint(canvas, pt, cv::Scalar(255, 0, 0), 5);
+            if ((pointBounds(pt, 5) & roi).area() > 0) {
+                drawPoint(view, pt - offset, cv::Scalar(255, 0, 0), 5);
+            }
         }
 
+        cv::Point off = roi.tl();
         if (isDeterminingPointPosition && clickedPointForSearch.x != -1) {
-            drawPoint(canvas, clickedPointForSearch, cv::Scalar(0, 0, 255));
+            drawPoint(view, clickedPointForSearch - off, cv::Scalar(0, 0, 255));
         }
         if (isDrawingIntersectionEdge && intersectionEdgePoints.size() == 1) {
-            drawPoint(canvas, intersectionEdgePoints[0], cv::Scalar(0, 255, 0));
+            drawPoint(view, intersectionEdgePoints[0] - off, cv::Scalar(0, 255, 0));
         }
         if (isDrawingIntersectionEdge && intersectionEdgePoints.size() == 2) {
-            drawLine(canvas, intersectionEdgePoints[0], intersectionEdgePoints[1], cv::Scalar(0, 255, 0));
+            drawLine(view, intersectionEdgePoints[0] - off, intersectionEdgePoints[1] - off, cv::Scalar(0, 255, 0));
         }
         if (isCheckingPointInPolygon && clickedPointForSearch.x != -1) {
-            drawPoint(canvas, clickedPointForSearch, cv::Scalar(0, 0, 255));
+            drawPoint(view, clickedPointForSearch - off, cv::Scalar(0, 0, 255));
+        }
+    }
+
+    // Overlapping rectangles are merged; when they cover most of the canvas it is redone as a whole.
+    void mergeRects(vector<cv::Rect>& rects) {
+        bool merged = true;
+        while (merged) {
+            merged = false;
+            for (size_t i = 0; i < rects.size() && !merged; ++i) {
+                for (size_t j = i + 1; j < rects.size(); ++j) {
+                    if ((rects[i] & rects[j]).area() > 0) {
+                        rects[i] |= rects[j];
+                        rects.erase(rects.begin() + j);
+                        merged = true;
+                        break;
+                    }
+                }
+            }
+        }
+        long long total = 0;
+        for (const auto& r : rects) {
+            total += r.area();
+        }
+        if (total * 2 > (long long)canvas.cols * canvas.rows) {
+            rects.assign(1, cv::Rect(0, 0, canvas.cols, canvas.rows));
         }
     }
 
-    cv::Point2f applyTransformation(const cv::Point& p, const cv::Mat& transformMatrix) {
-        cv::Mat pointMat = (cv::Mat_<double>(3, 1) << p.x, p.y, 1.0);
-        cv::Mat transformedPointMat = transformMatrix * pointMat;
-        return cv::Point2f(transformedPointMat.at<double>(0, 0), transformedPointMat.at<double>(1, 0));
+    void presentCanvas() {
+        if (polygonLayer.size() != canvas.size()) {
+            polygonLayer = cv::Mat(canvas.size(), CV_8UC3);
+            redrawScene();
+        }
+        if (canvasDirty.empty()) {
+            return;
+        }
+        mergeRects(layerDirty);
+        mergeRects(canvasDirty);
+        for (const auto& r : layerDirty) {
+            renderPolygons(r);
+        }
+        for (const auto& r : canvasDirty) {
+            polygonLayer(r).copyTo(canvas(r));
+            renderOverlay(r);
+        }
+        layerDirty.clear();
+        canvasDirty.clear();
+        cv::imshow("Canvas", canvas);
     }
 
     cv::Point getPolygonCenter(const std::vector<cv::Point>& poly) {
@@ -77,43 +260,41 @@ namespace Lab04 {
         return cv::Point(static_cast<int>(sumX / poly.size()), static_cast<int>(sumY / poly.size()));
     }
 
-    void applyAffineTransformation(int transformType, cv::Point transformRefPoint = cv::Point(0, 0)) {
-        if (polygons.empty()) return;
-
-        cv::Mat transformMatrix = cv::Mat::eye(3, 3, CV_64F);
-
+    // "Around its center" transforms depend on the polygon, the others are the same for all of them.
+    Affine2D makeTransform(int transformType, cv::Point transformRefPoint, const std::vector<cv::Point>& poly) {
         if (transformType == 0) {
-            transformMatrix = (cv::Mat_<double>(3, 3) <<
-                1, 0, transformDx,
-                0, 1, transformDy,
-                0, 0, 1);
+            return Affine2D::translation(transformDx, transformDy);
         }
         else if (transformType == 1 || transformType == 2) {
-            double angleRad = rotationAngle * CV_PI / 180.0;
-            cv::Point center = (transformType == 1) ? transformRefPoint : getPolygonCenter(polygons.back());
-
-            cv::Mat T1 = (cv::Mat_<double>(3, 3) << 1, 0, -center.x, 0, 1, -center.y, 0, 0, 1);
-            cv::Mat R = (cv::Mat_<double>(3, 3) << cos(angleRad), -sin(angleRad), 0, sin(angleRad), cos(
-                angleRad), 0, 0, 0, 1);
-            cv::Mat T2 = (cv::Mat_<double>(3, 3) << 1, 0, center.x, 0, 1, center.y, 0, 0, 1);
-            transformMatrix = T2 * R * T1;
+            cv::Point center = (transformType == 1) ? transformRefPoint : getPolygonCenter(poly);
+            return Affine2D::around(center.x, center.y, Affine2D::rotation(rotationAngle * CV_PI / 180.0));
         }
         else if (transformType == 3 || transformType == 4) {
-            cv::Point center = (transformType == 3) ? transformRefPoint : getPolygonCenter(polygons.back());
-
-            cv::Mat T1 = (cv::Mat_<double>(3, 3) << 1, 0, -center.x, 0, 1, -center.y, 0, 0, 1);
-            cv::Mat S = (cv::Mat_<double>(3, 3) << scaleX, 0, 0, 0, scaleY, 0, 0, 0, 1);
-            cv::Mat T2 = (cv::Mat_<double>(3, 3) << 1, 0, center.x, 0, 1, center.y, 0, 0, 1);
-            transformMatrix = T2 * S * T1;
+            cv::Point center = (transformType == 3) ? transformRefPoint : getPolygonCenter(poly);
+            return Affine2D::around(center.x, center.y, Affine2D::scaling(scaleX, scaleY));
         }
+        return Affine2D::identity();
+    }
+
+    void applyAffineTransformation(int transformType, cv::Point transformRefPoint = cv::Point(0, 0)) {
+        if (polygons.empty()) return;
 
-        if (!polygons.empty()) {
-            std::vector<cv::Point>& currentPoly = polygons.back();
-            for (auto& p : currentPoly) {
-                p = applyTransformation(p, transformMatrix);
+        if (transformAllPolygons) {
+            for (size_t i = 0; i < polygons.size(); ++i) {
+                transformPoints(makeTransform(transformType, transformRefPoint, polygons[i]), polygons[i]);
+                updatePolygonBounds(i);
+                updatePolygonEdges(i);
             }
+            redrawScene();
+        }
+        else {
+            size_t last = polygons.size() - 1;
+            invalidateLayer(polygonBounds[last]);
+            transformPoints(makeTransform(transformType, transformRefPoint, polygons[last]), polygons[last]);
+            updatePolygonBounds(last);
+            updatePolygonEdges(last);
+            invalidateLayer(polygonBounds[last]);
         }
-        redrawScene();
     }
 
     std::string classifyPointRelativeToEdge(cv::Point p, cv::Point p1, cv::Point p2) {
@@ -143,28 +324,122 @@ namespace Lab04 {
         return cv::Point2f(-1, -1);
     }
 
+    // The crossing x is compared exactly: with p2.y > p1.y, p.x < x iff (p.x - p1.x) * dy < dx * (p.y - p1.y).
     bool isPointInPolygon(cv::Point p, const std::vector<cv::Point>& poly) {
         if (poly.empty()) return false;
         int intersections = 0;
         for (size_t i = 0; i < poly.size(); ++i) {
             cv::Point p1 = poly[i];
             cv::Point p2 = poly[(i + 1) % poly.size()];
+            if (p1.y > p2.y) std::swap(p1, p2);
 
-            if (((p1.y <= p.y && p.y < p2.y) || (p2.y <= p.y && p.y < p1.y)) &&
-                (p.x < (p2.x - p1.x) * (p.y - p1.y) / (p2.y - p1.y) + p1.x)) {
+            if (p1.y <= p.y && p.y < p2.y &&
+                (long long)(p.x - p1.x) * (p2.y - p1.y) < (long long)(p2.x - p1.x) * (p.y - p1.y)) {
                 intersections++;
             }
         }
         return intersections % 2 == 1;
     }
 
+    // Every point where edges of the scene meet, except the shared vertex of two consecutive edges of one polygon.
+    void findAllSceneIntersections() {
+        vector<Segment> segments;
+        vector<std::pair<int, int>> owner;  // segment id -> (polygon, edge)
+        for (size_t i = 0; i < polygons.size(); ++i) {
+            const auto& poly = polygons[i];
+            for (size_t j = 0; j < poly.size(); ++j) {
+                segments.push_back({ poly[j], poly[(j + 1) % poly.size()], (int)owner.size() });
+                owner.emplace_back((int)i, (int)j);
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        vector<SegmentIntersection> found;
+        if (!findAllIntersections(segments, found)) {
+            printf("Coordinates are out of range (%d)\n", maxSweepCoordinate);
+            return;
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        auto sharedVertex = [&](const SegmentIntersection& in) {
+            if (in.segments.size() != 2) return false;
+            auto [p1, e1] = owner[in.segments[0]];
+            auto [p2, e2] = owner[in.segments[1]];
+            if (p1 != p2) return false;
+            const auto& poly = polygons[p1];
+            int n = (int)poly.size();
+            return ((e1 + 1) % n == e2 && in.point == cv::Point2d(poly[e2])) ||
+                ((e2 + 1) % n == e1 && in.point == cv::Point2d(poly[e1]));
+        };
+
+        invalidateOverlay();
+        intersectionPoints.clear();
+        for (const auto& in : found) {
+            if (!sharedVertex(in)) {
+                intersectionPoints.emplace_back((float)in.point.x, (float)in.point.y);
+            }
+        }
+        invalidateOverlay();
+        printf("Intersections: %zu (%zu edges, %.1f ms)\n", intersectionPoints.size(), segments.size(), ms);
+    }
+
+    // Star with many spikes (neither convex nor y-monotone) and a convex polygon with as many vertices,
+    // each against a few million random points. isPointInPolygon is timed on a sample and must agree.
+    void benchmarkPointInPolygon() {
+        const int vertices = 20000;
+        const size_t queries = 4000000, sample = 20000;
+        std::mt19937 rng(332);
+        std::uniform_int_distribution<int> coord(0, 1279);
+
+        std::vector<cv::Point> points(queries);
+        for (auto& p : points) {
+            p = cv::Point(coord(rng), coord(rng));
+        }
+
+        std::vector<cv::Point> star(vertices), convex(vertices);
+        for (int i = 0; i < vertices; ++i) {
+            double angle = 2 * CV_PI * i / vertices;
+            double r = (i % 2) ? 300 : 600;
+            star[i] = cv::Point(640 + cvRound(r * cos(angle)), 640 + cvRound(r * sin(angle)));
+            convex[i] = cv::Point(640 + cvRound(600 * cos(angle)), 640 + cvRound(600 * sin(angle)));
+        }
+
+        auto ms = [](auto start) {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        };
+        std::vector<uint8_t> inside(queries);
+        for (const auto* poly : { &star, &convex }) {
+            auto start = std::chrono::steady_clock::now();
+            PolygonIndex index(*poly);
+            double buildMs = ms(start);
+
+            start = std::chrono::steady_clock::now();
+            index.containsBatch(points.data(), points.size(), inside.data());
+            double batchMs = ms(start);
+
+            start = std::chrono::steady_clock::now();
+            size_t mismatches = 0;
+            for (size_t i = 0; i < sample; ++i) {
+                mismatches += isPointInPolygon(points[i], *poly) != (inside[i] != 0);
+            }
+            double bruteMs = ms(start);
+
+            printf("%s, %d vertices (%s): build %.1f ms, %zu points %.1f ms (%.1f ns/point), "
+                "isPointInPolygon %.1f ns/point, mismatches %zu\n",
+                poly == &star ? "Star" : "Convex", vertices,
+                index.isMonotone() ? "monotone chains" : index.hasRowSlabs() ? "row slabs" : "bands",
+                buildMs, queries, batchMs, batchMs * 1e6 / queries, bruteMs * 1e6 / sample, mismatches);
+        }
+    }
+
     void onMouse(int event, int x, int y, int flags, void* userdata) {
         if (event == cv::EVENT_LBUTTONDOWN) {
             cv::Point mousePoint(x, y);
 
             if (isDeterminingPointPosition) {
+                invalidateOverlay();
                 clickedPointForSearch = mousePoint;
-                redrawScene();
+                invalidateOverlay();
                 if (!polygons.empty() && !polygons.back().empty()) {
                     cv::Point edgeStart = polygons.back()[0];
                     cv::Point edgeEnd = polygons.back()[1 % polygons.back().size()];
@@ -174,35 +449,37 @@ namespace Lab04 {
                 }
             }
             else if (isDrawingIntersectionEdge) {
+                invalidateOverlay();
                 intersectionEdgePoints.push_back(mousePoint);
-                redrawScene();
+                invalidateOverlay();
                 if (intersectionEdgePoints.size() == 2) {
                     cv::Point pA = intersectionEdgePoints[0];
                     cv::Point pB = intersectionEdgePoints[1];
                     bool foundIntersection = false;
-                    for (const auto& poly : polygons) {
-                        for (size_t i = 0; i < poly.size(); ++i) {
-                            cv::Point pC = poly[i];
-                            cv::Point pD = poly[(i + 1) % poly.size()];
-                            cv::Point2f intersection = findIntersection(pA, pB, pC, pD);
-                            if (intersection.x != -1) {
-                                intersectionPoints.push_back(intersection);
-                                printf("����� �����������: (%.0f, %.0f)\n", intersection.x, intersection.y);
-                                foundIntersection = true;
-                            }
+                    for (long long key : edgeGrid.candidates(pA, pB)) {
+                        const auto& poly = polygons[key >> 32];
+                        size_t i = (size_t)(key & 0xffffffff);
+                        cv::Point pC = poly[i];
+                        cv::Point pD = poly[(i + 1) % poly.size()];
+                        cv::Point2f intersection = findIntersection(pA, pB, pC, pD);
+                        if (intersection.x != -1) {
+                            intersectionPoints.push_back(intersection);
+                            printf("����� �����������: (%.0f, %.0f)\n", intersection.x, intersection.y);
+                            foundIntersection = true;
                         }
                     }
                     if (!foundIntersection) {
                         printf("����������� �� �������.\n");
                     }
+                    invalidateOverlay();
                     intersectionEdgePoints.clear();
                     isDrawingIntersectionEdge = false;
-                    redrawScene();
                 }
             }
             else if (isCheckingPointInPolygon) {
+                invalidateOverlay();
                 clickedPointForSearch = mousePoint;
-                redrawScene();
+                invalidateOverlay();
                 if (!polygons.empty()) {
                     bool inPoly = isPointInPolygon(mousePoint, polygons.back());
                     if (inPoly) {
@@ -212,6 +489,15 @@ namespace Lab04 {
                         printf("����� (%d, %d) �� ����������� ��������.\n", mousePoint.x, mousePoint.y);
                     }
                 }
+
+                vector<int> hits;
+                polygonTree.queryPoint(mousePoint, [&](int i) {
+                    if (isPointInPolygon(mousePoint, polygons[i])) hits.push_back(i);
+                });
+                std::sort(hits.begin(), hits.end());
+                printf("Polygons containing (%d, %d):", mousePoint.x, mousePoint.y);
+                for (int i : hits) printf(" %d", i);
+                printf(hits.empty() ? " none\n" : "\n");
             }
             else {
                 if (polygons.empty() || polygons.back().empty() || polygons.back().back() != mousePoint) {
@@ -219,8 +505,18 @@ namespace Lab04 {
                         polygons.push_back({});
                         polygonColors.push_back(currentColor);
                     }
-                    polygons.back().push_back(mousePoint);
-                    redrawScene();
+                    // The old closing edge goes away, the edges to and from the new vertex appear.
+                    auto& poly = polygons.back();
+                    if (!poly.empty()) {
+                        invalidateLayer(segmentBounds(poly.back(), poly.front()) |
+                            segmentBounds(poly.back(), mousePoint) | segmentBounds(mousePoint, poly.front()));
+                    }
+                    else {
+                        invalidateLayer(pointBounds(mousePoint, 1));
+                    }
+                    poly.push_back(mousePoint);
+                    updatePolygonBounds(polygons.size() - 1);
+                    updatePolygonEdges(polygons.size() - 1, poly.size() >= 2 ? poly.size() - 2 : 0);
                 }
             }
         }
@@ -283,6 +579,10 @@ namespace Lab04 {
             if (ImGui::Button("Clear")) {
                 polygons.clear();
                 polygonColors.clear();
+                polygonBounds.clear();
+                polygonTree.clear();
+                polygonFills.clear();
+                edgeGrid.clear();
                 clickedPointForSearch = cv::Point(-1, -1);
                 intersectionEdgePoints.clear();
                 intersectionPoints.clear();
@@ -297,6 +597,8 @@ namespace Lab04 {
                 currentColor = cv::Scalar(rand() % 256, rand() % 256, rand() % 256);
                 polygons.push_back({});
                 polygonColors.push_back(currentColor);
+                polygonBounds.push_back(cv::Rect());
+                invalidateOverlay();
                 isDeterminingPointPosition = false;
                 isDrawingIntersectionEdge = false;
                 isCheckingPointInPolygon = false;
@@ -305,6 +607,9 @@ namespace Lab04 {
             }
 
             ImGui::ColorEdit3("Color", (float*)&currentColor);
+            if (ImGui::Checkbox("Fill polygons", &fillPolygons)) {
+                redrawScene();
+            }
 
             ImGui::Separator();
             ImGui::Text("Affine transformations");
@@ -325,6 +630,7 @@ namespace Lab04 {
                 ImGui::InputFloat("Scale Y", &scaleY);
             }
 
+            ImGui::Checkbox("Apply to all polygons", &transformAllPolygons);
             if (ImGui::Button("Apply")) {
                 cv::Point refPoint = cv::Point(canvas.cols / 2, canvas.rows / 2);
                 if (clickedPointForSearch.x != -1) {
@@ -339,12 +645,12 @@ namespace Lab04 {
             ImGui::Combo("Algorithm", &currentSearch, search_items, IM_ARRAYSIZE(search_items));
 
             if (ImGui::Button("Select mode")) {
+                invalidateOverlay();
                 isDeterminingPointPosition = false;
                 isDrawingIntersectionEdge = false;
                 isCheckingPointInPolygon = false;
                 clickedPointForSearch = cv::Point(-1, -1);
                 intersectionEdgePoints.clear();
-                redrawScene();
 
                 if (currentSearch == 0) {
                     isDeterminingPointPosition = true;
@@ -361,6 +667,15 @@ namespace Lab04 {
                 ImGui::CloseCurrentPopup();
             }
 
+            if (ImGui::Button("Find all intersections")) {
+                findAllSceneIntersections();
+            }
+
+            ImGui::SameLine();
+            if (ImGui::Button("Benchmark point in polygon")) {
+                benchmarkPointInPolygon();
+            }
+
             ImGui::End();
 
             ImGui::Render();
@@ -371,7 +686,7 @@ namespace Lab04 {
             glClear(GL_COLOR_BUFFER_BIT);
             ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
-            cv::imshow("Canvas", canvas);
+            presentCanvas();
             cv::waitKey(1);
 
             glfwSwapBuffers(window);
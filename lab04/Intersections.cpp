@@ -0,0 +1,280 @@
+#include "Intersections.h"
+
+#include <map>
+#include <set>
+
+namespace Lab04 {
+
+    namespace {
+#if defined(__SIZEOF_INT128__)
+        using Wide = __int128;
+#else
+        using Wide = long double;  // no 128-bit integer: exact only while products fit the mantissa
+#endif
+
+        // (x / d, y / d), d > 0. Intersection points share one denominator for both coordinates.
+        struct RPoint {
+            long long x, y, d;
+        };
+
+        // Sweep order: by y (top to bottom on screen), then by x.
+        bool before(const RPoint& p, const RPoint& q) {
+            Wide l = (Wide)p.y * q.d, r = (Wide)q.y * p.d;
+            if (l != r) return l < r;
+            return (Wide)p.x * q.d < (Wide)q.x * p.d;
+        }
+
+        struct EventOrder {
+            bool operator()(const RPoint& p, const RPoint& q) const {
+                return before(p, q);
+            }
+        };
+
+        long long cross(long long ax, long long ay, long long bx, long long by) {
+            return ax * by - ay * bx;
+        }
+
+        // n / d rounded down, d > 0.
+        long long floorDiv(long long n, long long d) {
+            return n >= 0 ? n / d : -((-n + d - 1) / d);
+        }
+
+        // (cx, cy) packed from their 32-bit patterns, so negative cells never shift a negative value.
+        long long cellKey(long long cx, long long cy) {
+            return (long long)(((unsigned long long)(uint32_t)cy << 32) | (uint32_t)cx);
+        }
+
+        class Sweep {
+        public:
+            // Every segment is oriented so that a comes first in sweep order.
+            std::vector<Segment> segs;
+
+            void run(std::vector<SegmentIntersection>& out);
+
+        private:
+            struct Probe {};  // the current event point in status lookups
+
+            // Status order: x where the segment crosses the sweep line y = p.y, then the order just
+            // below the event (by slope, horizontal last), then id. Horizontal segments in the status
+            // always contain p, so their x is p.x. Only keys are compared against a Probe.
+            struct StatusOrder {
+                using is_transparent = void;
+                const Sweep* sweep;
+
+                bool operator()(int s, int t) const {
+                    return sweep->compare(s, t) < 0;
+                }
+
+                bool operator()(int s, Probe) const {
+                    return sweep->compareToEvent(s) < 0;
+                }
+
+                bool operator()(Probe, int t) const {
+                    return sweep->compareToEvent(t) > 0;
+                }
+            };
+
+            // x of segment s on the current sweep line as num / den, den > 0.
+            void xAt(int s, Wide& num, Wide& den) const;
+
+            int compareToEvent(int s) const;
+
+            int compare(int s, int t) const;
+
+            void findEvent(int s, int t);
+
+            RPoint p{ 0, 0, 1 };
+            std::set<int, StatusOrder> status{ StatusOrder{ this } };
+            std::vector<std::set<int, StatusOrder>::iterator> where;
+            std::map<RPoint, std::vector<int>, EventOrder> queue;
+        };
+
+        void Sweep::xAt(int s, Wide& num, Wide& den) const {
+            const Segment& g = segs[s];
+            long long dx = g.b.x - g.a.x, dy = g.b.y - g.a.y;
+            if (dy == 0) {
+                num = p.x;
+                den = p.d;
+                return;
+            }
+            num = (Wide)g.a.x * dy * p.d + (Wide)dx * (p.y - (Wide)g.a.y * p.d);
+            den = (Wide)dy * p.d;
+        }
+
+        int Sweep::compareToEvent(int s) const {
+            Wide num, den;
+            xAt(s, num, den);
+            Wide l = num * p.d, r = (Wide)p.x * den;
+            return (l > r) - (l < r);
+        }
+
+        int Sweep::compare(int s, int t) const {
+            if (s == t) return 0;
+            Wide ns, ds, nt, dt;
+            xAt(s, ns, ds);
+            xAt(t, nt, dt);
+            Wide l = ns * dt, r = nt * ds;
+            if (l != r) return l < r ? -1 : 1;
+
+            const Segment& a = segs[s];
+            const Segment& b = segs[t];
+            long long ady = a.b.y - a.a.y, bdy = b.b.y - b.a.y;
+            if ((ady == 0) != (bdy == 0)) return ady == 0 ? 1 : -1;
+            if (ady != 0) {
+                long long c = (long long)(a.b.x - a.a.x) * bdy - (long long)(b.b.x - b.a.x) * ady;
+                if (c != 0) return c < 0 ? -1 : 1;
+            }
+            return a.id != b.id ? (a.id < b.id ? -1 : 1) : (s < t ? -1 : 1);
+        }
+
+        void Sweep::findEvent(int s, int t) {
+            const Segment& g = segs[s];
+            const Segment& h = segs[t];
+            long long rx = g.b.x - g.a.x, ry = g.b.y - g.a.y;
+            long long sx = h.b.x - h.a.x, sy = h.b.y - h.a.y;
+            long long qx = h.a.x - g.a.x, qy = h.a.y - g.a.y;
+            long long den = cross(rx, ry, sx, sy);
+            if (den == 0) return;  // parallel: shared points are endpoints, which are events anyway
+            long long tn = cross(qx, qy, sx, sy), un = cross(qx, qy, rx, ry);
+            if (den < 0) {
+                den = -den;
+                tn = -tn;
+                un = -un;
+            }
+            if (tn < 0 || tn > den || un < 0 || un > den) return;
+
+            RPoint q{ g.a.x * den + rx * tn, g.a.y * den + ry * tn, den };
+            if (before(p, q)) {
+                queue[q];
+            }
+        }
+
+        void Sweep::run(std::vector<SegmentIntersection>& out) {
+            where.assign(segs.size(), status.end());
+            for (int s = 0; s < (int)segs.size(); ++s) {
+                queue[RPoint{ segs[s].a.x, segs[s].a.y, 1 }].push_back(s);
+                queue[RPoint{ segs[s].b.x, segs[s].b.y, 1 }];
+            }
+
+            std::vector<int> through, reinsert;
+            while (!queue.empty()) {
+                auto event = queue.begin();
+                p = event->first;
+                std::vector<int> upper = std::move(event->second);
+                queue.erase(event);
+
+                // Segments in the status containing p: those ending here and those passing through.
+                auto range = status.equal_range(Probe{});
+                through.assign(range.first, range.second);
+                if (upper.size() + through.size() > 1) {
+                    SegmentIntersection found{ cv::Point2d((double)p.x / p.d, (double)p.y / p.d), {} };
+                    for (int s : upper) found.segments.push_back(segs[s].id);
+                    for (int s : through) found.segments.push_back(segs[s].id);
+                    out.push_back(std::move(found));
+                }
+
+                reinsert = upper;
+                for (int s : through) {
+                    status.erase(where[s]);
+                    where[s] = status.end();
+                    RPoint end{ segs[s].b.x, segs[s].b.y, 1 };
+                    if (before(end, p) || before(p, end)) reinsert.push_back(s);
+                }
+                for (int s : reinsert) {
+                    where[s] = status.insert(s).first;
+                }
+
+                range = status.equal_range(Probe{});
+                if (range.first == range.second) {
+                    if (range.first != status.begin() && range.second != status.end()) {
+                        findEvent(*std::prev(range.first), *range.second);
+                    }
+                    continue;
+                }
+                if (range.first != status.begin()) {
+                    findEvent(*std::prev(range.first), *range.first);
+                }
+                if (range.second != status.end()) {
+                    findEvent(*std::prev(range.second), *range.second);
+                }
+            }
+        }
+    }
+
+    bool findAllIntersections(const std::vector<Segment>& segments, std::vector<SegmentIntersection>& out) {
+        out.clear();
+        Sweep sweep;
+        sweep.segs.reserve(segments.size());
+        for (Segment s : segments) {
+            for (cv::Point q : { s.a, s.b }) {
+                if (std::abs(q.x) > maxSweepCoordinate || std::abs(q.y) > maxSweepCoordinate) {
+                    return false;
+                }
+            }
+            if (s.a == s.b) continue;
+            if (s.b.y < s.a.y || (s.b.y == s.a.y && s.b.x < s.a.x)) std::swap(s.a, s.b);
+            sweep.segs.push_back(s);
+        }
+        sweep.run(out);
+        return true;
+    }
+
+    // Integer arithmetic throughout: the x of the segment at a row boundary is the fraction
+    // (a.x * dy + dx * (y - a.y)) / dy, and its cell is found by exact floor division, so every point
+    // of the segment, endpoints included, lands in the cell that contains it.
+    template<class F>
+    void SegmentGrid::forEachCell(cv::Point a, cv::Point b, F&& f) const {
+        if (a.y > b.y) std::swap(a, b);
+        const long long dx = b.x - a.x, dy = b.y - a.y;
+        auto cellAt = [&](long long y) {
+            return dy == 0 ? floorDiv(a.x, cell) : floorDiv(a.x * dy + dx * (y - a.y), dy * cell);
+        };
+        for (long long cy = floorDiv(a.y, cell), last = floorDiv(b.y, cell); cy <= last; ++cy) {
+            // Part of the segment inside this row of cells.
+            long long y0 = std::max<long long>(a.y, cy * cell), y1 = std::min<long long>(b.y, (cy + 1) * cell);
+            long long cx0 = cellAt(y0), cx1 = dy == 0 ? floorDiv(b.x, cell) : cellAt(y1);
+            if (cx0 > cx1) std::swap(cx0, cx1);
+            for (long long cx = cx0; cx <= cx1; ++cx) {
+                f(cellKey(cx, cy));
+            }
+        }
+    }
+
+    void SegmentGrid::clear() {
+        segments.clear();
+        cells.clear();
+    }
+
+    void SegmentGrid::insert(long long key, cv::Point a, cv::Point b) {
+        remove(key);
+        segments[key] = { a, b };
+        forEachCell(a, b, [&](long long c) { cells[c].push_back(key); });
+    }
+
+    void SegmentGrid::remove(long long key) {
+        auto it = segments.find(key);
+        if (it == segments.end()) return;
+        forEachCell(it->second.a, it->second.b, [&](long long c) {
+            auto& list = cells[c];
+            auto pos = std::find(list.begin(), list.end(), key);
+            if (pos != list.end()) {
+                *pos = list.back();
+                list.pop_back();
+            }
+            if (list.empty()) cells.erase(c);
+        });
+        segments.erase(it);
+    }
+
+    std::vector<long long> SegmentGrid::candidates(cv::Point a, cv::Point b) const {
+        std::vector<long long> keys;
+        forEachCell(a, b, [&](long long c) {
+            auto it = cells.find(c);
+            if (it != cells.end()) keys.insert(keys.end(), it->second.begin(), it->second.end());
+        });
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        return keys;
+    }
+
+}
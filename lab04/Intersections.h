@@ -0,0 +1,59 @@
+#pragma once
+
+#include "../provider.h"
+
+#include <unordered_map>
+
+namespace Lab04 {
+
+    struct Segment {
+        cv::Point a, b;
+        int id;
+    };
+
+    struct SegmentIntersection {
+        cv::Point2d point;
+        std::vector<int> segments;  // ids of all segments through the point
+    };
+
+    // Predicates are exact (128-bit integers) for coordinates within this bound.
+    constexpr int maxSweepCoordinate = 32767;
+
+    // Bentley-Ottmann sweep: every point where two or more segments meet, touching endpoints included,
+    // in O((n + k) log n). Collinear overlapping segments are reported at the endpoints inside the
+    // overlap; zero-length segments are ignored. Returns false if a coordinate is out of range.
+    bool findAllIntersections(const std::vector<Segment>& segments, std::vector<SegmentIntersection>& out);
+
+    // Uniform grid of segments for incremental queries: which stored segments a new one can hit,
+    // without a sweep over the whole scene. Keys are chosen by the caller; insert replaces.
+    class SegmentGrid {
+    public:
+        explicit SegmentGrid(int cellSize = 32) : cell(cellSize) {}
+
+        void clear();
+
+        void insert(long long key, cv::Point a, cv::Point b);
+
+        void remove(long long key);
+
+        // Keys of stored segments sharing a cell with a-b: a superset of those intersecting it.
+        std::vector<long long> candidates(cv::Point a, cv::Point b) const;
+
+        size_t size() const {
+            return segments.size();
+        }
+
+    private:
+        struct Entry {
+            cv::Point a, b;
+        };
+
+        template<class F>
+        void forEachCell(cv::Point a, cv::Point b, F&& f) const;
+
+        int cell;
+        std::unordered_map<long long, Entry> segments;
+        std::unordered_map<long long, std::vector<long long>> cells;
+    };
+
+}
@@ -0,0 +1,46 @@
+#include "LooseQuadtree.h"
+
+namespace Lab04 {
+
+    void LooseQuadtree::clear() {
+        items.clear();
+        for (int level = 0; level <= levels; ++level) {
+            nodes[level].clear();
+            count[level] = 0;
+        }
+    }
+
+    void LooseQuadtree::update(int id, const cv::Rect& box) {
+        remove(id);
+        if (id >= (int)items.size()) items.resize(id + 1);
+
+        int extent = std::max(box.width, box.height);
+        int level = oversized;
+        long long cell = 0;
+        if (extent <= rootSize) {
+            level = 0;
+            while (level + 1 < levels && (rootSize >> (level + 1)) >= extent) ++level;
+            const long long size = rootSize >> level;
+            cell = cellKey(floorDiv((long long)box.x + box.width / 2, size), floorDiv((long long)box.y + box.height / 2, size));
+        }
+
+        auto& node = nodes[level][cell];
+        items[id] = { box, level, cell, (int)node.size() };
+        node.push_back(id);
+        count[level]++;
+    }
+
+    void LooseQuadtree::remove(int id) {
+        if (!contains(id)) return;
+        Item& item = items[id];
+        auto node = nodes[item.level].find(item.cell);
+        auto& ids = node->second;
+        ids[item.slot] = ids.back();
+        items[ids[item.slot]].slot = item.slot;
+        ids.pop_back();
+        if (ids.empty()) nodes[item.level].erase(node);
+        count[item.level]--;
+        item.level = -1;
+    }
+
+}
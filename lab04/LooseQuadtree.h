@@ -0,0 +1,96 @@
+#pragma once
+
+#include "../provider.h"
+
+#include <unordered_map>
+
+namespace Lab04 {
+
+    // Loose quadtree over bounding boxes, addressed implicitly: node (level, cx, cy) has size
+    // rootSize >> level and its loose bounds are twice as large, centered on it. A box is stored in the
+    // deepest level whose nodes are at least as large as the box, in the node containing its center,
+    // so insert, remove and update are O(1). A query visits, level by level, only the nodes whose
+    // loose bounds overlap it: a point query touches at most four nodes per level.
+    class LooseQuadtree {
+    public:
+        static constexpr int rootSize = 1 << 20;
+        static constexpr int levels = 17;  // the smallest nodes are 16 px
+
+        void clear();
+
+        // Inserts id or moves it to the new box. Ids are small non-negative integers (e.g. indices).
+        void update(int id, const cv::Rect& box);
+
+        void remove(int id);
+
+        bool contains(int id) const {
+            return id >= 0 && id < (int)items.size() && items[id].level >= 0;
+        }
+
+        // Calls f(id) for every box intersecting area (boxes are half-open, like cv::Rect).
+        template<class F>
+        void query(const cv::Rect& area, F&& f) const;
+
+        template<class F>
+        void queryPoint(cv::Point p, F&& f) const {
+            query(cv::Rect(p.x, p.y, 1, 1), f);
+        }
+
+    private:
+        static constexpr int oversized = levels;  // boxes larger than the root, always tested
+
+        struct Item {
+            cv::Rect box;
+            int level = -1;
+            long long cell = 0;
+            int slot = 0;
+        };
+
+        // cy is shifted as unsigned: a left shift of a negative value is undefined before C++20.
+        static long long cellKey(long long cx, long long cy) {
+            return (long long)(((unsigned long long)(uint32_t)cy << 32) | (uint32_t)cx);
+        }
+
+        static long long floorDiv(long long a, long long b) {
+            return a >= 0 ? a / b : -((-a + b - 1) / b);
+        }
+
+        std::vector<Item> items;
+        std::unordered_map<long long, std::vector<int>> nodes[levels + 1];
+        size_t count[levels + 1] = {};
+    };
+
+    template<class F>
+    void LooseQuadtree::query(const cv::Rect& area, F&& f) const {
+        if (area.width <= 0 || area.height <= 0) return;
+        auto test = [&](int id) {
+            if ((items[id].box & area).area() > 0) f(id);
+        };
+
+        for (const auto& node : nodes[oversized]) {
+            for (int id : node.second) test(id);
+        }
+        for (int level = 0; level < levels; ++level) {
+            if (count[level] == 0) continue;
+            const long long size = rootSize >> level, half = size / 2;
+            long long x0 = floorDiv((long long)area.x - half, size), x1 = floorDiv((long long)area.x + area.width + half, size);
+            long long y0 = floorDiv((long long)area.y - half, size), y1 = floorDiv((long long)area.y + area.height + half, size);
+            const auto& level_nodes = nodes[level];
+            if ((x1 - x0 + 1) * (y1 - y0 + 1) > (long long)level_nodes.size()) {
+                // Fewer occupied nodes than nodes under the query: scan them instead.
+                for (const auto& node : level_nodes) {
+                    for (int id : node.second) test(id);
+                }
+                continue;
+            }
+            for (long long cy = y0; cy <= y1; ++cy) {
+                for (long long cx = x0; cx <= x1; ++cx) {
+                    auto it = level_nodes.find(cellKey(cx, cy));
+                    if (it == level_nodes.end()) continue;
+                    for (int id : it->second) test(id);
+                }
+            }
+        }
+    }
+
+}
@@ -0,0 +1,185 @@
+#include "PolygonIndex.h"
+
+#include <thread>
+
+namespace Lab04 {
+
+    void PolygonIndex::build(const std::vector<cv::Point>& poly) {
+        leftChain.clear();
+        rightChain.clear();
+        rowStart.clear();
+        rowCross.clear();
+        bandStart.clear();
+        bandEdges.clear();
+        monotone = false;
+        if (poly.size() < 2) {
+            return;
+        }
+
+        minY = maxY = poly[0].y;
+        for (const auto& p : poly) {
+            minY = std::min(minY, p.y);
+            maxY = std::max(maxY, p.y);
+        }
+        monotone = buildMonotone(poly);
+        if (monotone) {
+            return;
+        }
+
+        std::vector<Edge> edges;
+        edges.reserve(poly.size());
+        for (size_t i = 0; i < poly.size(); ++i) {
+            cv::Point a = poly[i], b = poly[(i + 1) % poly.size()];
+            if (a.y == b.y) continue;  // never crossed
+            if (a.y > b.y) std::swap(a, b);
+            edges.push_back({ a.x, a.y, b.x, b.y });
+        }
+        if (!buildRows(edges)) {
+            buildBands(edges);
+        }
+    }
+
+    bool PolygonIndex::buildMonotone(const std::vector<cv::Point>& poly) {
+        size_t n = poly.size();
+        size_t start = 0;
+        for (size_t i = 1; i < n; ++i) {
+            if (poly[i].y < poly[start].y) start = i;
+        }
+
+        // From the lowest y the cyclic sequence has to rise (or stay) and then fall (or stay) back.
+        size_t steps = 0, i = start;
+        while (steps < n && poly[(i + 1) % n].y >= poly[i].y) {
+            i = (i + 1) % n;
+            ++steps;
+        }
+        size_t top = i;
+        while (steps < n && poly[(i + 1) % n].y <= poly[i].y) {
+            i = (i + 1) % n;
+            ++steps;
+        }
+        if (steps != n) {
+            return false;
+        }
+
+        for (i = start;; i = (i + 1) % n) {
+            leftChain.push_back(poly[i]);
+            if (i == top) break;
+        }
+        for (i = start;; i = (i + n - 1) % n) {
+            rightChain.push_back(poly[i]);
+            if (i == top) break;
+        }
+        return true;
+    }
+
+    bool PolygonIndex::buildRows(const std::vector<Edge>& edges) {
+        size_t total = 0;
+        for (const auto& e : edges) total += e.y2 - e.y1;
+        if (total > maxRowEntries) {
+            return false;
+        }
+
+        const int rows = maxY - minY;
+        rowStart.assign(rows + 1, 0);
+        for (const auto& e : edges) {
+            rowStart[e.y1 - minY + 1]++;
+            if (e.y2 - minY < rows) rowStart[e.y2 - minY + 1]--;
+        }
+        for (int r = 0; r < rows; ++r) rowStart[r + 1] += rowStart[r];  // edges per row
+        for (int r = 0; r < rows; ++r) rowStart[r + 1] += rowStart[r];  // prefix offsets
+        rowCross.resize(total);
+
+        std::vector<int> fill(rowStart.begin(), rowStart.end() - 1);
+        for (const auto& e : edges) {
+            const long long dy = e.y2 - e.y1, dx = e.x2 - e.x1;
+            for (int y = e.y1; y < e.y2; ++y) {
+                long long num = dx * (y - e.y1);
+                long long q = num >= 0 ? (num + dy - 1) / dy : -((-num) / dy);  // ceil(num / dy)
+                rowCross[fill[y - minY]++] = (int)(e.x1 + q);
+            }
+        }
+        for (int r = 0; r < rows; ++r) {
+            std::sort(rowCross.begin() + rowStart[r], rowCross.begin() + rowStart[r + 1]);
+        }
+        return true;
+    }
+
+    void PolygonIndex::buildBands(const std::vector<Edge>& edges) {
+        // About one band per edge, fewer if long edges would be copied into too many bands.
+        const long long maxEntries = std::max<long long>(8 * (long long)edges.size(), maxRowEntries);
+        const long long height = (long long)maxY - minY;
+        long long bands = std::max<long long>(1, std::min<long long>((long long)edges.size(), height));
+        auto entries = [&](long long h) {
+            long long total = 0;
+            for (const auto& e : edges) total += (e.y2 - 1 - minY) / h - (e.y1 - minY) / h + 1;
+            return total;
+        };
+        bandHeight = (int)((height + bands - 1) / bands);
+        while (bands > 1 && entries(bandHeight) > maxEntries) {
+            bands = (bands + 1) / 2;
+            bandHeight = (int)((height + bands - 1) / bands);
+        }
+        bands = (height + bandHeight - 1) / bandHeight;
+
+        bandStart.assign(bands + 1, 0);
+        for (const auto& e : edges) {
+            for (int b = (e.y1 - minY) / bandHeight; b <= (e.y2 - 1 - minY) / bandHeight; ++b) bandStart[b + 1]++;
+        }
+        for (size_t b = 0; b < (size_t)bands; ++b) bandStart[b + 1] += bandStart[b];
+        bandEdges.resize(bandStart[bands]);
+        std::vector<int> fill(bandStart.begin(), bandStart.end() - 1);
+        for (const auto& e : edges) {
+            for (int b = (e.y1 - minY) / bandHeight; b <= (e.y2 - 1 - minY) / bandHeight; ++b) bandEdges[fill[b]++] = e;
+        }
+    }
+
+    bool PolygonIndex::chainCrosses(const std::vector<cv::Point>& chain, cv::Point p) {
+        auto it = std::upper_bound(chain.begin(), chain.end(), p.y,
+            [](int y, const cv::Point& v) { return y < v.y; });
+        if (it == chain.begin() || it == chain.end()) {
+            return false;
+        }
+        Edge e = { (it - 1)->x, (it - 1)->y, it->x, it->y };
+        return crosses(e, p);
+    }
+
+    bool PolygonIndex::contains(cv::Point p) const {
+        if (p.y < minY || p.y >= maxY) {
+            return false;
+        }
+        if (monotone) {
+            return chainCrosses(leftChain, p) != chainCrosses(rightChain, p);
+        }
+        if (!rowStart.empty()) {
+            int r = p.y - minY;
+            auto begin = rowCross.begin() + rowStart[r], end = rowCross.begin() + rowStart[r + 1];
+            return (end - std::upper_bound(begin, end, p.x)) % 2 == 1;
+        }
+        if (bandStart.empty()) {
+            return false;
+        }
+        int b = (p.y - minY) / bandHeight;
+        bool inside = false;
+        for (int i = bandStart[b]; i < bandStart[b + 1]; ++i) {
+            inside ^= crosses(bandEdges[i], p);
+        }
+        return inside;
+    }
+
+    void PolygonIndex::containsBatch(const cv::Point* points, size_t count, uint8_t* out, int threads) const {
+        if (threads <= 0) threads = (int)std::max(1u, std::thread::hardware_concurrency());
+        threads = (int)std::max<size_t>(1, std::min<size_t>(threads, count / 4096));
+
+        auto work = [&](int t) {
+            size_t begin = count * t / threads, end = count * (t + 1) / threads;
+            for (size_t i = begin; i < end; ++i) {
+                out[i] = contains(points[i]);
+            }
+        };
+        std::vector<std::thread> workers;
+        for (int t = 1; t < threads; ++t) workers.emplace_back(work, t);
+        work(0);
+        for (auto& w : workers) w.join();
+    }
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "../provider.h"
+
+namespace Lab04 {
+
+    // Preprocessed polygon for fast point-in-polygon queries. The answer is the crossing-number
+    // (even-odd) rule of isPointInPolygon: an edge counts when p.y is in [min y, max y) of the edge
+    // and p lies strictly left of it.
+    //
+    // y-monotone polygons (every convex one is) are split into two chains sorted by y, and a query
+    // binary-searches the one edge of each chain it can cross: O(log n). Other polygons get one-row
+    // slabs holding the sorted crossings of the row, so a query is one binary search too. When the
+    // crossings would take too much memory, edges are bucketed into taller bands instead and a query
+    // tests the edges of its band.
+    class PolygonIndex {
+    public:
+        // Row slab entries allowed before falling back to bands.
+        static constexpr size_t maxRowEntries = size_t(1) << 23;
+
+        PolygonIndex() = default;
+
+        explicit PolygonIndex(const std::vector<cv::Point>& poly) {
+            build(poly);
+        }
+
+        void build(const std::vector<cv::Point>& poly);
+
+        bool contains(cv::Point p) const;
+
+        // out[i] = contains(points[i]); the batch is split between threads (0 = all cores).
+        void containsBatch(const cv::Point* points, size_t count, uint8_t* out, int threads = 0) const;
+
+        bool isMonotone() const {
+            return monotone;
+        }
+
+        bool hasRowSlabs() const {
+            return !rowStart.empty();
+        }
+
+        size_t bandCount() const {
+            return bandStart.empty() ? 0 : bandStart.size() - 1;
+        }
+
+    private:
+        // Oriented so that y1 < y2; the edge covers rows [y1, y2).
+        struct Edge {
+            int x1, y1, x2, y2;
+        };
+
+        static bool crosses(const Edge& e, cv::Point p) {
+            return p.y >= e.y1 && p.y < e.y2 &&
+                (long long)(p.x - e.x1) * (e.y2 - e.y1) < (long long)(e.x2 - e.x1) * (p.y - e.y1);
+        }
+
+        static bool chainCrosses(const std::vector<cv::Point>& chain, cv::Point p);
+
+        bool buildMonotone(const std::vector<cv::Point>& poly);
+
+        bool buildRows(const std::vector<Edge>& edges);
+
+        void buildBands(const std::vector<Edge>& edges);
+
+        bool monotone = false;
+        int minY = 0, maxY = 0;
+
+        // Monotone case: vertices of both chains with y non-decreasing.
+        std::vector<cv::Point> leftChain, rightChain;
+
+        // Row slabs: for row y, rowCross[rowStart[y - minY], rowStart[y - minY + 1]) are the sorted
+        // ceil(x) of the crossings; an integer p.x is left of a crossing iff it is less than that value.
+        std::vector<int> rowStart;
+        std::vector<int> rowCross;
+
+        // Bands: edges of band b are bandEdges[bandStart[b], bandStart[b + 1]).
+        int bandHeight = 1;
+        std::vector<int> bandStart;
+        std::vector<Edge> bandEdges;
+    };
+
+}
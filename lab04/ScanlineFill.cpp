@@ -0,0 +1,120 @@
+#include "ScanlineFill.h"
+
+namespace Lab04 {
+
+    namespace {
+        long long floorDiv(long long a, long long b) {
+            return a >= 0 ? a / b : -((-a + b - 1) / b);
+        }
+
+        // Crossing of row y is x1 + q with q = ceil(dx * (y - y1) / dy), kept exactly by stepping q and
+        // the remainder e = q * dy - dx * (y - y1), 0 <= e < dy.
+        struct ActiveEdge {
+            int yEnd;
+            int x1;
+            long long q, e;
+            long long stepQ, stepR, dy;
+            int dir;
+
+            int x() const {
+                return (int)(x1 + q);
+            }
+
+            void step() {
+                q += stepQ;
+                e -= stepR;
+                if (e < 0) {
+                    q += 1;
+                    e += dy;
+                }
+            }
+        };
+
+        struct EdgeEntry {
+            int y1, y2, x1, x2, dir;
+        };
+    }
+
+    void fillEdges(cv::Mat& img, const std::vector<std::pair<cv::Point, cv::Point>>& edges, FillRule rule,
+        const cv::Scalar& color, cv::Point offset) {
+        CV_Assert(img.type() == CV_8UC3);
+        std::vector<EdgeEntry> table;
+        table.reserve(edges.size());
+        for (const auto& [a0, b0] : edges) {
+            cv::Point a = a0 - offset, b = b0 - offset;
+            if (a.y == b.y) continue;
+            if (a.y < b.y) table.push_back({ a.y, b.y, a.x, b.x, 1 });
+            else table.push_back({ b.y, a.y, b.x, a.x, -1 });
+        }
+        std::sort(table.begin(), table.end(), [](const EdgeEntry& l, const EdgeEntry& r) { return l.y1 < r.y1; });
+        if (table.empty()) return;
+
+        int yEnd = 0;
+        for (const auto& t : table) yEnd = std::max(yEnd, t.y2);
+        yEnd = std::min(yEnd, img.rows);
+        const cv::Vec3b pixel = cv::Vec3b(cv::saturate_cast<uchar>(color[0]), cv::saturate_cast<uchar>(color[1]),
+            cv::saturate_cast<uchar>(color[2]));
+
+        std::vector<ActiveEdge> active;
+        std::vector<std::pair<int, int>> crossings;
+        size_t next = 0;
+        for (int y = std::max(0, table[0].y1); y < yEnd; ++y) {
+            // Edges starting above the image enter at its first row.
+            for (; next < table.size() && table[next].y1 <= y; ++next) {
+                const EdgeEntry& t = table[next];
+                if (t.y2 <= y) continue;
+                long long dx = t.x2 - t.x1, dy = t.y2 - t.y1;
+                long long v = dx * (y - t.y1);
+                long long q = -floorDiv(-v, dy);
+                ActiveEdge edge{ t.y2, t.x1, q, q * dy - v, floorDiv(dx, dy), 0, dy, t.dir };
+                edge.stepR = dx - edge.stepQ * dy;
+                active.push_back(edge);
+            }
+            active.erase(std::remove_if(active.begin(), active.end(),
+                [y](const ActiveEdge& edge) { return edge.yEnd <= y; }), active.end());
+
+            crossings.clear();
+            for (const auto& edge : active) crossings.emplace_back(edge.x(), edge.dir);
+            std::sort(crossings.begin(), crossings.end());
+
+            cv::Vec3b* row = img.ptr<cv::Vec3b>(y);
+            auto span = [&](int from, int to) {
+                from = std::max(from, 0);
+                to = std::min(to, img.cols);
+                if (from < to) std::fill(row + from, row + to, pixel);
+            };
+            if (rule == FillRule::EVEN_ODD) {
+                for (size_t k = 0; k + 1 < crossings.size(); k += 2) span(crossings[k].first, crossings[k + 1].first);
+            }
+            else {
+                int winding = 0;
+                for (size_t k = 0; k + 1 < crossings.size(); ++k) {
+                    winding += crossings[k].second;
+                    if (winding != 0) span(crossings[k].first, crossings[k + 1].first);
+                }
+            }
+
+            for (auto& edge : active) edge.step();
+        }
+    }
+
+    void fillPolygon(cv::Mat& img, const std::vector<cv::Point>& poly, const cv::Scalar& color, cv::Point offset) {
+        std::vector<std::pair<cv::Point, cv::Point>> edges;
+        edges.reserve(poly.size());
+        for (size_t i = 0; i < poly.size(); ++i) edges.emplace_back(poly[i], poly[(i + 1) % poly.size()]);
+        fillEdges(img, edges, FillRule::EVEN_ODD, color, offset);
+    }
+
+    void fillTriangles(cv::Mat& img, const std::vector<cv::Point>& poly, const std::vector<cv::Vec3i>& triangles,
+        const cv::Scalar& color, cv::Point offset) {
+        std::vector<std::pair<cv::Point, cv::Point>> edges;
+        edges.reserve(triangles.size() * 3);
+        for (const auto& t : triangles) {
+            edges.emplace_back(poly[t[0]], poly[t[1]]);
+            edges.emplace_back(poly[t[1]], poly[t[2]]);
+            edges.emplace_back(poly[t[2]], poly[t[0]]);
+        }
+        fillEdges(img, edges, FillRule::NON_ZERO, color, offset);
+    }
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "../provider.h"
+
+namespace Lab04 {
+
+    enum class FillRule {
+        EVEN_ODD,
+        NON_ZERO
+    };
+
+    // Active-edge-table scanline fill of a CV_8UC3 image. Pixel (x, y) is filled when its integer
+    // position is inside under rule, with the crossing convention of isPointInPolygon: an edge covers
+    // rows [min y, max y) and a pixel is left of it when x < ceil(crossing x). Spans are written
+    // straight into the rows. Coordinates are shifted by -offset first (to draw into a sub-image).
+    void fillEdges(cv::Mat& img, const std::vector<std::pair<cv::Point, cv::Point>>& edges, FillRule rule,
+        const cv::Scalar& color, cv::Point offset = cv::Point(0, 0));
+
+    // Even-odd fill of the polygon outline; works for self-intersecting polygons too.
+    void fillPolygon(cv::Mat& img, const std::vector<cv::Point>& poly, const cv::Scalar& color,
+        cv::Point offset = cv::Point(0, 0));
+
+    // Fills a triangulation of poly (consistently oriented triangles). Diagonals shared by two triangles
+    // cancel in the non-zero rule, so the result equals the polygon fill without seams or overdraw.
+    void fillTriangles(cv::Mat& img, const std::vector<cv::Point>& poly, const std::vector<cv::Vec3i>& triangles,
+        const cv::Scalar& color, cv::Point offset = cv::Point(0, 0));
+
+}
@@ -0,0 +1,354 @@
+#include "Triangulation.h"
+#include "Intersections.h"
+
+#include <set>
+
+namespace Lab04 {
+
+    namespace {
+        // The algorithms below use the textbook frame: y up, polygon counter-clockwise. Points with
+        // equal y are ordered by x, which acts as an infinitesimal rotation so no edge is horizontal.
+        struct Vertex {
+            long long x, y;
+        };
+
+        bool above(const Vertex& p, const Vertex& q) {
+            return p.y > q.y || (p.y == q.y && p.x < q.x);
+        }
+
+        long long orient(const Vertex& a, const Vertex& b, const Vertex& c) {
+            return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        }
+
+        enum VertexType { START, END, SPLIT, MERGE, REGULAR };
+
+        class MonotonePartition {
+        public:
+            explicit MonotonePartition(const std::vector<Vertex>& v) : v(v), n((int)v.size()) {}
+
+            std::vector<std::pair<int, int>> diagonals;
+
+            void run();
+
+        private:
+            struct Probe {
+                Vertex p;
+            };
+
+            // Edges of the status are left boundaries of the interior; edge i joins vertex i and i + 1.
+            struct EdgeOrder {
+                using is_transparent = void;
+                const MonotonePartition* m;
+
+                bool operator()(int a, int b) const {
+                    return m->edgeLess(a, b);
+                }
+
+                bool operator()(int a, const Probe& p) const {
+                    return orient(m->lower(a), m->upper(a), p.p) < 0;
+                }
+
+                bool operator()(const Probe& p, int b) const {
+                    return orient(m->lower(b), m->upper(b), p.p) > 0;
+                }
+            };
+
+            const Vertex& upper(int e) const {
+                const Vertex& a = v[e];
+                const Vertex& b = v[(e + 1) % n];
+                return above(a, b) ? a : b;
+            }
+
+            const Vertex& lower(int e) const {
+                const Vertex& a = v[e];
+                const Vertex& b = v[(e + 1) % n];
+                return above(a, b) ? b : a;
+            }
+
+            // Edges in the status never cross, so comparing the later-starting edge's upper endpoint
+            // with the other edge gives a consistent order.
+            bool edgeLess(int a, int b) const {
+                if (a == b) return false;
+                bool flip = above(upper(a), upper(b));
+                int first = flip ? a : b, second = flip ? b : a;
+                long long o = orient(lower(first), upper(first), upper(second));
+                if (o == 0) o = orient(lower(first), upper(first), lower(second));
+                if (o == 0) return a < b;
+                // o < 0: second lies right of first.
+                return flip ? o < 0 : o > 0;
+            }
+
+            int leftOf(int i) const {
+                auto it = status.lower_bound(Probe{ v[i] });
+                return it == status.begin() ? -1 : *std::prev(it);
+            }
+
+            void insertEdge(int e, int helperVertex) {
+                where[e] = status.insert(e).first;
+                helper[e] = helperVertex;
+            }
+
+            void eraseEdge(int e) {
+                status.erase(where[e]);
+                where[e] = status.end();
+            }
+
+            void connectIfMerge(int i, int e) {
+                if (e >= 0 && type[helper[e]] == MERGE) diagonals.emplace_back(i, helper[e]);
+            }
+
+            const std::vector<Vertex>& v;
+            int n;
+            std::vector<VertexType> type;
+            std::vector<int> helper;
+            std::set<int, EdgeOrder> status{ EdgeOrder{ this } };
+            std::vector<std::set<int, EdgeOrder>::iterator> where;
+        };
+
+        void MonotonePartition::run() {
+            type.resize(n);
+            helper.assign(n, -1);
+            where.assign(n, status.end());
+            for (int i = 0; i < n; ++i) {
+                const Vertex& prev = v[(i + n - 1) % n];
+                const Vertex& next = v[(i + 1) % n];
+                bool convex = orient(prev, v[i], next) > 0;
+                if (above(v[i], prev) && above(v[i], next)) type[i] = convex ? START : SPLIT;
+                else if (above(prev, v[i]) && above(next, v[i])) type[i] = convex ? END : MERGE;
+                else type[i] = REGULAR;
+            }
+
+            std::vector<int> order(n);
+            for (int i = 0; i < n; ++i) order[i] = i;
+            std::sort(order.begin(), order.end(), [&](int a, int b) { return above(v[a], v[b]); });
+
+            for (int i : order) {
+                int prevEdge = (i + n - 1) % n;
+                switch (type[i]) {
+                case START:
+                    insertEdge(i, i);
+                    break;
+                case END:
+                    connectIfMerge(i, prevEdge);
+                    eraseEdge(prevEdge);
+                    break;
+                case SPLIT: {
+                    int left = leftOf(i);
+                    if (left >= 0) {
+                        diagonals.emplace_back(i, helper[left]);
+                        helper[left] = i;
+                    }
+                    insertEdge(i, i);
+                    break;
+                }
+                case MERGE: {
+                    connectIfMerge(i, prevEdge);
+                    eraseEdge(prevEdge);
+                    int left = leftOf(i);
+                    connectIfMerge(i, left);
+                    if (left >= 0) helper[left] = i;
+                    break;
+                }
+                case REGULAR:
+                    if (above(v[(i + n - 1) % n], v[i])) {
+                        // The interior lies right of the vertex: it is on a left boundary.
+                        connectIfMerge(i, prevEdge);
+                        eraseEdge(prevEdge);
+                        insertEdge(i, i);
+                    }
+                    else {
+                        int left = leftOf(i);
+                        connectIfMerge(i, left);
+                        if (left >= 0) helper[left] = i;
+                    }
+                    break;
+                }
+            }
+        }
+
+        // Counter-clockwise angular order of directions around a vertex.
+        bool angleLess(const Vertex& d1, const Vertex& d2) {
+            int h1 = d1.y < 0 || (d1.y == 0 && d1.x < 0);
+            int h2 = d2.y < 0 || (d2.y == 0 && d2.x < 0);
+            if (h1 != h2) return h1 < h2;
+            return d1.x * d2.y - d1.y * d2.x > 0;
+        }
+
+        // Walks the faces of the polygon split by the diagonals; each is returned counter-clockwise.
+        std::vector<std::vector<int>> monotonePieces(const std::vector<Vertex>& v,
+            const std::vector<std::pair<int, int>>& diagonals) {
+            const int n = (int)v.size();
+            std::vector<std::vector<int>> adj(n);
+            for (int i = 0; i < n; ++i) {
+                adj[i].push_back((i + 1) % n);
+                adj[(i + 1) % n].push_back(i);
+            }
+            for (auto [a, b] : diagonals) {
+                adj[a].push_back(b);
+                adj[b].push_back(a);
+            }
+
+            auto direction = [&](int from, int to) { return Vertex{ v[to].x - v[from].x, v[to].y - v[from].y }; };
+            std::vector<int> offset(n + 1, 0);
+            for (int i = 0; i < n; ++i) {
+                std::sort(adj[i].begin(), adj[i].end(),
+                    [&](int a, int b) { return angleLess(direction(i, a), direction(i, b)); });
+                offset[i + 1] = offset[i] + (int)adj[i].size();
+            }
+            auto position = [&](int at, int to) {
+                auto it = std::lower_bound(adj[at].begin(), adj[at].end(), to,
+                    [&](int a, int b) { return angleLess(direction(at, a), direction(at, b)); });
+                return (int)(it - adj[at].begin());
+            };
+
+            std::vector<char> used(offset[n], 0);
+            std::vector<std::vector<int>> faces;
+            auto walk = [&](int from, int to) {
+                int start = offset[from] + position(from, to);
+                if (used[start]) return;
+                std::vector<int> face;
+                int u = from, w = to;
+                while (true) {
+                    int half = offset[u] + position(u, w);
+                    if (used[half]) break;
+                    used[half] = 1;
+                    face.push_back(u);
+                    // Next boundary edge: the first one clockwise from the way back.
+                    int back = position(w, u), deg = (int)adj[w].size();
+                    int next = adj[w][(back + deg - 1) % deg];
+                    u = w;
+                    w = next;
+                }
+                faces.push_back(std::move(face));
+            };
+            for (int i = 0; i < n; ++i) walk(i, (i + 1) % n);
+            for (auto [a, b] : diagonals) {
+                walk(a, b);
+                walk(b, a);
+            }
+            return faces;
+        }
+
+        void triangulateMonotone(const std::vector<Vertex>& v, const std::vector<int>& face,
+            std::vector<cv::Vec3i>& out) {
+            const int m = (int)face.size();
+            if (m < 3) return;
+            int top = 0, bottom = 0;
+            for (int k = 1; k < m; ++k) {
+                if (above(v[face[k]], v[face[top]])) top = k;
+                if (above(v[face[bottom]], v[face[k]])) bottom = k;
+            }
+            // Counter-clockwise from the top vertex runs down the left chain.
+            std::vector<char> left(m, 0);
+            for (int k = top; k != bottom; k = (k + 1) % m) left[k] = 1;
+
+            std::vector<int> order(m);
+            for (int k = 0; k < m; ++k) order[k] = k;
+            std::sort(order.begin(), order.end(), [&](int a, int b) { return above(v[face[a]], v[face[b]]); });
+
+            auto emit = [&](int a, int b, int c) {
+                int ia = face[a], ib = face[b], ic = face[c];
+                if (orient(v[ia], v[ib], v[ic]) < 0) std::swap(ib, ic);
+                out.emplace_back(ia, ib, ic);
+            };
+
+            std::vector<int> stack = { order[0], order[1] };
+            for (int j = 2; j < m - 1; ++j) {
+                int u = order[j];
+                if (left[u] != left[stack.back()]) {
+                    while (stack.size() > 1) {
+                        int a = stack.back();
+                        stack.pop_back();
+                        emit(u, a, stack.back());
+                    }
+                    stack.clear();
+                    stack.push_back(order[j - 1]);
+                    stack.push_back(u);
+                }
+                else {
+                    int last = stack.back();
+                    stack.pop_back();
+                    while (!stack.empty()) {
+                        long long o = orient(v[face[stack.back()]], v[face[last]], v[face[u]]);
+                        if (left[u] ? o <= 0 : o >= 0) break;
+                        emit(u, last, stack.back());
+                        last = stack.back();
+                        stack.pop_back();
+                    }
+                    stack.push_back(last);
+                    stack.push_back(u);
+                }
+            }
+            int u = order[m - 1];
+            while (stack.size() > 1) {
+                int a = stack.back();
+                stack.pop_back();
+                emit(u, a, stack.back());
+            }
+        }
+
+        bool isSimple(const std::vector<cv::Point>& poly) {
+            std::vector<Segment> edges;
+            for (size_t i = 0; i < poly.size(); ++i) {
+                edges.push_back({ poly[i], poly[(i + 1) % poly.size()], (int)i });
+            }
+            std::vector<SegmentIntersection> found;
+            if (!findAllIntersections(edges, found)) return false;
+            const int n = (int)poly.size();
+            for (const auto& in : found) {
+                if (in.segments.size() != 2) return false;
+                int a = in.segments[0], b = in.segments[1];
+                bool shared = ((a + 1) % n == b && in.point == cv::Point2d(poly[b])) ||
+                    ((b + 1) % n == a && in.point == cv::Point2d(poly[a]));
+                if (!shared) return false;
+            }
+            return true;
+        }
+    }
+
+    bool triangulatePolygon(const std::vector<cv::Point>& poly, std::vector<cv::Vec3i>& triangles) {
+        triangles.clear();
+
+        // Consecutive duplicates carry no edge.
+        std::vector<int> index;
+        for (int i = 0; i < (int)poly.size(); ++i) {
+            if (index.empty() || poly[index.back()] != poly[i]) index.push_back(i);
+        }
+        while (index.size() > 1 && poly[index.back()] == poly[index.front()]) index.pop_back();
+        if (index.size() < 3) return false;
+
+        std::vector<cv::Point> unique(index.size());
+        for (size_t k = 0; k < index.size(); ++k) unique[k] = poly[index[k]];
+        if (!isSimple(unique)) return false;
+
+        // Screen y points down: flip it, then make the order counter-clockwise.
+        std::vector<Vertex> v(unique.size());
+        long long area = 0;
+        for (size_t k = 0; k < unique.size(); ++k) v[k] = { unique[k].x, -(long long)unique[k].y };
+        for (size_t k = 0; k < v.size(); ++k) {
+            const Vertex& a = v[k];
+            const Vertex& b = v[(k + 1) % v.size()];
+            area += a.x * b.y - a.y * b.x;
+        }
+        if (area == 0) return false;
+        if (area < 0) {
+            std::reverse(v.begin(), v.end());
+            std::reverse(index.begin(), index.end());
+        }
+
+        MonotonePartition partition(v);
+        partition.run();
+        for (const auto& face : monotonePieces(v, partition.diagonals)) {
+            triangulateMonotone(v, face, triangles);
+        }
+        if (triangles.size() != v.size() - 2) {
+            triangles.clear();
+            return false;
+        }
+        for (auto& t : triangles) {
+            t = cv::Vec3i(index[t[0]], index[t[1]], index[t[2]]);
+        }
+        return true;
+    }
+
+}
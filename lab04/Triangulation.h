@@ -0,0 +1,14 @@
+#pragma once
+
+#include "../provider.h"
+
+namespace Lab04 {
+
+    // Triangulation of a simple polygon by monotone partition, O(n log n): a sweep adds diagonals that
+    // split it into y-monotone pieces, and each piece is triangulated with the usual stack walk.
+    // Triangles hold vertex indices of poly and are oriented clockwise on screen. Returns false
+    // (and leaves triangles empty) for polygons that are not simple, have no area, or whose
+    // coordinates are beyond maxSweepCoordinate.
+    bool triangulatePolygon(const std::vector<cv::Point>& poly, std::vector<cv::Vec3i>& triangles);
+
+}
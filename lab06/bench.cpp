@@ -0,0 +1,141 @@
+// Headless benchmark for the lab06/lab07 software renderer.
+//
+//   render_bench <model.obj> [--frames N] [--size WxH] [--out DIR] [--lod]
+//
+// Loads the model, fits it to the default scene size and renders an orbiting camera path into an
+// offscreen framebuffer once per shading mode (wireframe, Gouraud, Phong toon, textured) plus the
+// lab07 z-buffer path. Prints ms/frame per mode and writes the first frame of each mode as PPM.
+// No window or ImGui context is created.
+
+#include "lab.h"
+#include "../lab07/zbuffer.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+    struct BenchOptions {
+        string model;
+        int frames = 120;
+        int width = 1200, height = 800;
+        string outDir = ".";
+        bool lod = false;
+    };
+
+    bool parseArgs(int argc, char **argv, BenchOptions &opt) {
+        for (int i = 1; i < argc; ++i) {
+            string a = argv[i];
+            auto next = [&]() -> const char * { return i + 1 < argc ? argv[++i] : nullptr; };
+            if (a == "--frames") {
+                const char *v = next();
+                if (!v) return false;
+                opt.frames = std::max(1, atoi(v));
+            } else if (a == "--size") {
+                const char *v = next();
+                if (!v || sscanf(v, "%dx%d", &opt.width, &opt.height) != 2) return false;
+            } else if (a == "--out") {
+                const char *v = next();
+                if (!v) return false;
+                opt.outDir = v;
+            } else if (a == "--lod") {
+                opt.lod = true;
+            } else if (!a.empty() && a[0] != '-' && opt.model.empty()) {
+                opt.model = a;
+            } else {
+                return false;
+            }
+        }
+        return !opt.model.empty() && opt.width > 0 && opt.height > 0;
+    }
+
+    // Centers the mesh at the origin and scales it to the radius of the built-in polyhedra.
+    Mat4 fitToScene(const Mesh &m) {
+        const BoundingSphere &s = m.bounds.sphere;
+        float k = s.radius > 1e-6f ? 150.f / s.radius : 1.f;
+        return Mat4::T(-s.center.x, -s.center.y, -s.center.z) * Mat4::S(k, k, k);
+    }
+
+    struct ModeResult {
+        const char *name;
+        double totalMs = 0, minMs = 1e30, maxMs = 0;
+        FrameCounters counters;
+    };
+
+}
+
+int main(int argc, char **argv) {
+    BenchOptions opt;
+    if (!parseArgs(argc, argv, opt)) {
+        fprintf(stderr, "usage: %s <model.obj> [--frames N] [--size WxH] [--out DIR] [--lod]\n", argv[0]);
+        return 2;
+    }
+
+    AppState S;
+    Mesh mesh;
+    if (!openObject(opt.model, S, mesh)) return 1;
+    S.base = mesh;
+    S.modelMat = fitToScene(mesh);
+    S.texture = makeCheckerTexture(256, 256, 8);
+    S.useLod = opt.lod;
+    waitForLod(S.base, S);
+    S.proj.perspective = true;
+    S.proj.scale = opt.height * 0.5f;
+    S.proj.cx = opt.width * 0.5f;
+    S.proj.cy = opt.height * 0.5f;
+    S.useCamera = true;
+    S.cameraOrbit = true;
+    S.camRadius = 400.f;
+    S.camPitch = 25.f;
+
+    printf("%s: %zu vertices, %zu faces, %d triangles, %dx%d, %d frames\n", opt.model.c_str(), mesh.V.size(),
+           mesh.F.size(), mesh.bounds.triCount, opt.width, opt.height, opt.frames);
+
+    FramebufferTarget fb(opt.width, opt.height);
+    lab7::ZBuffer zBuffer(opt.width, opt.height);
+    FrameProfiler &prof = FrameProfiler::instance();
+    const char *modeNames[] = {"wireframe", "gouraud", "phong_toon", "textured", "zbuffer"};
+    vector<ModeResult> results;
+
+    for (int mode = 0; mode < 5; ++mode) {
+        ModeResult r{modeNames[mode]};
+        S.shadingMode = mode < 4 ? mode : 1;
+        for (int frame = 0; frame < opt.frames; ++frame) {
+            S.camYaw = -180.f + 360.f * (float) frame / (float) opt.frames;
+            updateCameraOrbit(S);
+
+            auto t0 = std::chrono::steady_clock::now();
+            prof.beginFrame();
+            S.cullStats = {};
+            fb.clear(IM_COL32(245, 245, 245, 255));
+            const Mesh &drawn = selectLod(S.base, S.modelMat, S);
+            if (mode < 4) {
+                drawShaded(fb, drawn, S.modelMat, S);
+            } else {
+                zBuffer.clear();
+                ImU32 color = IM_COL32((int) (S.objectColor.x * 255), (int) (S.objectColor.y * 255),
+                                       (int) (S.objectColor.z * 255), 255);
+                lab7::drawMeshZBuffer(fb, drawn, S.modelMat, S, zBuffer, color, false);
+            }
+            prof.endFrame();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+            r.totalMs += ms;
+            r.minMs = std::min(r.minMs, ms);
+            r.maxMs = std::max(r.maxMs, ms);
+            if (frame == 0) {
+                r.counters = prof.counters;
+                string path = opt.outDir + "/bench_" + r.name + ".ppm";
+                if (!fb.writePPM(path)) fprintf(stderr, "Warning: couldn`t write %s\n", path.c_str());
+            }
+        }
+        results.push_back(r);
+    }
+
+    printf("%-12s %10s %10s %10s %12s %14s\n", "mode", "ms/frame", "min", "max", "tris drawn", "fragments");
+    for (const auto &r: results) {
+        printf("%-12s %10.3f %10.3f %10.3f %12lld %14lld\n", r.name, r.totalMs / opt.frames, r.minMs, r.maxMs,
+               (long long) r.counters.trianglesRasterized, (long long) r.counters.fragmentsShaded);
+    }
+    return 0;
+}
@@ -8,8 +8,16 @@
 #include <iostream>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <array>
+#include <unordered_map>
+#include <atomic>
+#include <chrono>
+#include <future>
 
 #include "../provider.h"
+#include "profiler.h"
+#include "render_target.h"
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
@@ -180,11 +188,88 @@ struct Vertex {
 struct Face {
     vector<int> idx;
 };
+
+struct AABB {
+    Vec3 min{1e30f, 1e30f, 1e30f};
+    Vec3 max{-1e30f, -1e30f, -1e30f};
+};
+
+struct BoundingSphere {
+    Vec3 center{};
+    float radius{};
+};
+
+// Consecutive run of faces with its own sphere: the second level of the culling hierarchy.
+struct FaceCluster {
+    int firstFace{}, faceCount{};
+    int triCount{};
+    BoundingSphere sphere;
+};
+
+struct MeshBounds {
+    bool valid = false;
+    AABB box;
+    BoundingSphere sphere;
+    int triCount{};
+    vector<FaceCluster> clusters;
+    uint64_t version{};  // changes with every updateBounds, so caches can key on it
+};
+
 struct Mesh {
     vector<Vertex> V;
     vector<Face> F;
+    MeshBounds bounds;
 };
 
+static constexpr int FACES_PER_CLUSTER = 64;
+
+inline MeshBounds computeBounds(const Mesh &m) {
+    MeshBounds B;
+    if (m.V.empty()) return B;
+    for (const auto &p: m.V) {
+        B.box.min = {std::min(B.box.min.x, p.x), std::min(B.box.min.y, p.y), std::min(B.box.min.z, p.z)};
+        B.box.max = {std::max(B.box.max.x, p.x), std::max(B.box.max.y, p.y), std::max(B.box.max.z, p.z)};
+    }
+    B.sphere.center = (B.box.min + B.box.max) * 0.5f;
+    for (const auto &p: m.V)
+        B.sphere.radius = std::max(B.sphere.radius, vlen(Vec3{p.x, p.y, p.z} - B.sphere.center));
+
+    for (int first = 0; first < (int) m.F.size(); first += FACES_PER_CLUSTER) {
+        FaceCluster C;
+        C.firstFace = first;
+        C.faceCount = std::min(FACES_PER_CLUSTER, (int) m.F.size() - first);
+        AABB box;
+        for (int fi = first; fi < first + C.faceCount; ++fi) {
+            const auto &f = m.F[fi];
+            if (f.idx.size() >= 3) C.triCount += (int) f.idx.size() - 2;
+            for (int i: f.idx) {
+                const Vertex &p = m.V[i];
+                box.min = {std::min(box.min.x, p.x), std::min(box.min.y, p.y), std::min(box.min.z, p.z)};
+                box.max = {std::max(box.max.x, p.x), std::max(box.max.y, p.y), std::max(box.max.z, p.z)};
+            }
+        }
+        C.sphere.center = (box.min + box.max) * 0.5f;
+        for (int fi = first; fi < first + C.faceCount; ++fi)
+            for (int i: m.F[fi].idx)
+                C.sphere.radius = std::max(C.sphere.radius,
+                                           vlen(Vec3{m.V[i].x, m.V[i].y, m.V[i].z} - C.sphere.center));
+        B.triCount += C.triCount;
+        B.clusters.push_back(C);
+    }
+    B.valid = true;
+    return B;
+}
+
+inline uint64_t nextMeshVersion() {
+    static std::atomic<uint64_t> counter{0};
+    return ++counter;
+}
+
+inline void updateBounds(Mesh &m) {
+    m.bounds = computeBounds(m);
+    m.bounds.version = nextMeshVersion();
+}
+
 inline Vec3 centroid(const Mesh &m) {
     Vec3 c{0, 0, 0};
     if (m.V.empty())return c;
@@ -214,6 +299,7 @@ inline Mesh makeCube(float s = 1.f) {
            {{3, 2, 6, 7}},
            {{1, 2, 6, 5}},
            {{0, 3, 7, 4}}};
+    updateBounds(P);
     return P;
 }
 
@@ -228,6 +314,7 @@ inline Mesh makeTetra(float s = 1.f) {
            {{0, 1, 3}},
            {{0, 2, 3}},
            {{1, 2, 3}}};
+    updateBounds(P);
     return P;
 }
 
@@ -248,6 +335,7 @@ inline Mesh makeOcta(float s = 1.f) {
            {{1, 3, 4}},
            {{1, 5, 3}},
            {{1, 2, 5}}};
+    updateBounds(P);
     return P;
 }
 
@@ -296,6 +384,7 @@ inline Mesh makeIcosa(float s = 1.f) {
             {{8,  6,  7}},
             {{9,  8,  1}}
     };
+    updateBounds(M);
     return M;
 }
 
@@ -337,6 +426,7 @@ inline Mesh makeDodeca(float s = 1.f) {
         for (auto &t: items)pent.idx.push_back(t.f);
         dode.F.push_back(std::move(pent));
     }
+    updateBounds(dode);
     return dode;
 }
 
@@ -350,10 +440,256 @@ inline Mesh transformMesh(const Mesh &original, const Mat4 &transform) {
     }
 
     newMesh.F = original.F;
+    updateBounds(newMesh);
 
     return newMesh;
 }
 
+// ---- LOD: quadric edge-collapse simplification (Garland-Heckbert) ----
+
+// Symmetric 4x4 error quadric, upper triangle only.
+struct Quadric {
+    double a[10]{};
+
+    static Quadric plane(double nx, double ny, double nz, double d, double w = 1.0) {
+        Quadric q;
+        q.a[0] = w * nx * nx; q.a[1] = w * nx * ny; q.a[2] = w * nx * nz; q.a[3] = w * nx * d;
+        q.a[4] = w * ny * ny; q.a[5] = w * ny * nz; q.a[6] = w * ny * d;
+        q.a[7] = w * nz * nz; q.a[8] = w * nz * d;
+        q.a[9] = w * d * d;
+        return q;
+    }
+
+    Quadric &operator+=(const Quadric &o) {
+        for (int i = 0; i < 10; ++i) a[i] += o.a[i];
+        return *this;
+    }
+
+    double eval(double x, double y, double z) const {
+        return a[0] * x * x + 2 * a[1] * x * y + 2 * a[2] * x * z + 2 * a[3] * x
+               + a[4] * y * y + 2 * a[5] * y * z + 2 * a[6] * y
+               + a[7] * z * z + 2 * a[8] * z + a[9];
+    }
+
+    // Minimizer of the quadric; false when the 3x3 part is (nearly) singular.
+    bool optimum(double &x, double &y, double &z) const {
+        double det = a[0] * (a[4] * a[7] - a[5] * a[5]) - a[1] * (a[1] * a[7] - a[5] * a[2])
+                     + a[2] * (a[1] * a[5] - a[4] * a[2]);
+        double scale = std::fabs(a[0]) + std::fabs(a[4]) + std::fabs(a[7]);
+        if (std::fabs(det) <= 1e-9 * scale * scale * scale || scale == 0.0) return false;
+        double inv = 1.0 / det;
+        x = -inv * (a[3] * (a[4] * a[7] - a[5] * a[5]) - a[6] * (a[1] * a[7] - a[2] * a[5]) + a[8] * (a[1] * a[5] - a[2] * a[4]));
+        y = inv * (a[3] * (a[1] * a[7] - a[2] * a[5]) - a[6] * (a[0] * a[7] - a[2] * a[2]) + a[8] * (a[0] * a[5] - a[1] * a[2]));
+        z = -inv * (a[3] * (a[1] * a[5] - a[2] * a[4]) - a[6] * (a[0] * a[5] - a[1] * a[2]) + a[8] * (a[0] * a[4] - a[1] * a[1]));
+        return true;
+    }
+};
+
+struct LodLevel {
+    Mesh mesh;
+    float error{};  // object-space distance the level may deviate from the original
+    int triCount{};
+};
+
+struct LodChain {
+    vector<LodLevel> levels;  // levels[0] is the original mesh
+};
+
+static constexpr int LOD_MIN_TRIANGLES = 32;
+static constexpr size_t LOD_CACHE_SIZE = 8;
+
+// A chain built in the background; lastUse orders the entries for eviction.
+struct LodCacheEntry {
+    std::shared_future<LodChain> chain;
+    uint64_t lastUse = 0;
+};
+
+// Simplifies the fan-triangulated mesh by repeated cheapest edge collapse and snapshots the
+// result every time the triangle count halves. Boundary edges get a stiff perpendicular
+// quadric so open borders stay in place; collapses that flip a neighbouring triangle are refused.
+inline LodChain buildLodChain(const Mesh &src, int maxLevels = 8) {
+    LodChain chain;
+    LodLevel original{src};
+    if (!original.mesh.bounds.valid) updateBounds(original.mesh);
+    original.triCount = original.mesh.bounds.triCount;
+    chain.levels.push_back(std::move(original));
+    if (chain.levels[0].triCount < LOD_MIN_TRIANGLES * 2) return chain;
+
+    using Tri = std::array<int, 3>;
+    vector<Tri> tris;
+    for (const auto &f: src.F)
+        for (size_t k = 1; k + 1 < f.idx.size(); ++k) tris.push_back({f.idx[0], f.idx[k], f.idx[k + 1]});
+
+    const int nV = (int) src.V.size();
+    vector<Vec3> P(nV);
+    for (int i = 0; i < nV; ++i) P[i] = {src.V[i].x, src.V[i].y, src.V[i].z};
+
+    vector<Quadric> Q(nV);
+    vector<vector<int>> vt(nV);  // vertex -> incident triangles (may hold dead ones)
+    vector<char> triAlive(tris.size(), 1);
+    std::unordered_map<uint64_t, int> edgeUse;
+    auto edgeKey = [](int a, int b) { return a < b ? (uint64_t) a << 32 | (uint32_t) b : (uint64_t) b << 32 | (uint32_t) a; };
+
+    for (size_t t = 0; t < tris.size(); ++t) {
+        const Tri &T = tris[t];
+        Vec3 n = cross(P[T[1]] - P[T[0]], P[T[2]] - P[T[0]]);
+        float len = vlen(n);
+        if (len < 1e-12f) {
+            triAlive[t] = 0;
+            continue;
+        }
+        n = n * (1.f / len);
+        Quadric q = Quadric::plane(n.x, n.y, n.z, -dot(n, P[T[0]]));
+        for (int k = 0; k < 3; ++k) {
+            Q[T[k]] += q;
+            vt[T[k]].push_back((int) t);
+            edgeUse[edgeKey(T[k], T[(k + 1) % 3])]++;
+        }
+    }
+
+    // Boundary edges: plane through the edge, perpendicular to the triangle.
+    for (size_t t = 0; t < tris.size(); ++t) {
+        if (!triAlive[t]) continue;
+        const Tri &T = tris[t];
+        Vec3 n = norm(cross(P[T[1]] - P[T[0]], P[T[2]] - P[T[0]]));
+        for (int k = 0; k < 3; ++k) {
+            int a = T[k], b = T[(k + 1) % 3];
+            if (edgeUse[edgeKey(a, b)] != 1) continue;
+            Vec3 e = P[b] - P[a];
+            Vec3 bn = cross(e, n);
+            float len = vlen(bn);
+            if (len < 1e-12f) continue;
+            bn = bn * (1.f / len);
+            Quadric q = Quadric::plane(bn.x, bn.y, bn.z, -dot(bn, P[a]), 1000.0);
+            Q[a] += q;
+            Q[b] += q;
+        }
+    }
+
+    struct Collapse {
+        double cost;
+        int a, b;
+        unsigned va, vb;
+        Vec3 pos;
+        bool operator<(const Collapse &o) const { return cost > o.cost; }
+    };
+    vector<unsigned> version(nV, 0);
+    vector<char> vAlive(nV, 1);
+    std::priority_queue<Collapse> heap;
+
+    auto evaluate = [&](int a, int b) {
+        Quadric q = Q[a];
+        q += Q[b];
+        double x, y, z;
+        Vec3 best;
+        double cost;
+        if (q.optimum(x, y, z)) {
+            best = {(float) x, (float) y, (float) z};
+            cost = q.eval(x, y, z);
+        } else {
+            Vec3 mid = (P[a] + P[b]) * 0.5f;
+            Vec3 cand[3] = {P[a], P[b], mid};
+            cost = 1e300;
+            for (const Vec3 &c: cand) {
+                double e = q.eval(c.x, c.y, c.z);
+                if (e < cost) cost = e, best = c;
+            }
+        }
+        heap.push({std::max(cost, 0.0), a, b, version[a], version[b], best});
+    };
+
+    for (const auto &[key, uses]: edgeUse) evaluate((int) (key >> 32), (int) (key & 0xffffffffu));
+
+    // Moving v to pos must not turn any surviving triangle around v upside down.
+    auto flips = [&](int v, int other, const Vec3 &pos) {
+        for (int t: vt[v]) {
+            if (!triAlive[t]) continue;
+            const Tri &T = tris[t];
+            if (T[0] == other || T[1] == other || T[2] == other) continue;
+            Vec3 p[3], q[3];
+            for (int k = 0; k < 3; ++k) {
+                p[k] = P[T[k]];
+                q[k] = T[k] == v ? pos : p[k];
+            }
+            Vec3 n0 = cross(p[1] - p[0], p[2] - p[0]);
+            Vec3 n1 = cross(q[1] - q[0], q[2] - q[0]);
+            if (dot(n0, n1) <= 0.2f * vlen(n0) * vlen(n1)) return true;
+        }
+        return false;
+    };
+
+    auto snapshot = [&](int liveTris, double maxCost) {
+        LodLevel L;
+        vector<int> remap(nV, -1);
+        for (size_t t = 0; t < tris.size(); ++t) {
+            if (!triAlive[t]) continue;
+            Face f;
+            for (int v: tris[t]) {
+                if (remap[v] < 0) {
+                    remap[v] = (int) L.mesh.V.size();
+                    L.mesh.V.push_back({P[v].x, P[v].y, P[v].z});
+                }
+                f.idx.push_back(remap[v]);
+            }
+            L.mesh.F.push_back(std::move(f));
+        }
+        updateBounds(L.mesh);
+        L.triCount = liveTris;
+        L.error = (float) std::sqrt(maxCost);
+        chain.levels.push_back(std::move(L));
+    };
+
+    int liveTris = 0;
+    for (char a: triAlive) liveTris += a;
+    int target = liveTris / 2;
+    double maxCost = 0.0;
+
+    while (!heap.empty() && (int) chain.levels.size() < maxLevels) {
+        Collapse c = heap.top();
+        heap.pop();
+        if (!vAlive[c.a] || !vAlive[c.b] || version[c.a] != c.va || version[c.b] != c.vb) continue;
+        if (flips(c.a, c.b, c.pos) || flips(c.b, c.a, c.pos)) continue;
+
+        // b collapses into a.
+        P[c.a] = c.pos;
+        Q[c.a] += Q[c.b];
+        vAlive[c.b] = 0;
+        version[c.a]++;
+        maxCost = std::max(maxCost, c.cost);
+        for (int t: vt[c.b]) {
+            if (!triAlive[t]) continue;
+            Tri &T = tris[t];
+            bool hasA = T[0] == c.a || T[1] == c.a || T[2] == c.a;
+            if (hasA) {
+                triAlive[t] = 0;
+                liveTris--;
+                continue;
+            }
+            for (int &v: T) if (v == c.b) v = c.a;
+            vt[c.a].push_back(t);
+        }
+        vt[c.b].clear();
+        vt[c.b].shrink_to_fit();
+
+        vector<int> &inc = vt[c.a];
+        inc.erase(std::remove_if(inc.begin(), inc.end(), [&](int t) { return !triAlive[t]; }), inc.end());
+        vector<int> ring;
+        for (int t: inc)
+            for (int v: tris[t])
+                if (v != c.a) ring.push_back(v);
+        std::sort(ring.begin(), ring.end());
+        ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+        for (int v: ring) evaluate(c.a, v);
+
+        if (liveTris <= target) {
+            snapshot(liveTris, maxCost);
+            if (liveTris / 2 < LOD_MIN_TRIANGLES) break;
+            target = liveTris / 2;
+        }
+    }
+    return chain;
+}
+
 struct Projector {
     bool perspective = true;
     float f = 600.f;
@@ -475,6 +811,11 @@ struct Camera {
 };
 
 
+struct CullStats {
+    int objectsTested{}, objectsCulled{};
+    int trianglesTested{}, trianglesCulled{};
+};
+
 struct MeshData {
     const char *name;
     PolyKind kind;
@@ -508,6 +849,14 @@ struct AppState {
     char axisSel = 'X';
 
     bool backfaceCull = true;
+    bool frustumCull = true;
+    mutable CullStats cullStats;
+    bool useLod = true;
+    float lodErrorPx = 1.f;
+    float lodTriAreaPx = 2.f;
+    mutable std::unordered_map<uint64_t, LodCacheEntry> lodCache;  // keyed by MeshBounds::version
+    mutable uint64_t lodClock = 0;
+    mutable int lodLevel = 0, lodLevels = 1, lodTriangles = 0;
     bool showFaceNormals = false;
     bool useCustomView = false;
     Vec3 viewVec{0.f, 0.f, 1.f};
@@ -623,19 +972,270 @@ static bool projectPoint(const AppState &S, const Vec3 &pw, int &X, int &Y) {
 }
 
 
-static void drawAxes(const AppState &S, float len = 250.f) {
-    ImDrawList *dl = ImGui::GetBackgroundDrawList();
+struct Plane {
+    Vec3 n{};
+    float d{};
+
+    float dist(const Vec3 &p) const { return dot(n, p) + d; }
+};
+
+// View volume of the current projection: the four screen-edge planes plus the near plane in perspective.
+// A point p is inside when dist(p) >= 0 for every plane.
+struct Frustum {
+    Plane planes[5];
+    int count = 0;
+
+    void add(const Vec3 &n, float d) {
+        float L = vlen(n);
+        if (L < 1e-12f) return;
+        planes[count++] = {n * (1.f / L), d / L};
+    }
+};
+
+enum class CullResult {
+    Outside, Intersect, Inside
+};
+
+static Frustum buildFrustum(const AppState &S, float marginPx = 2.f) {
+    const Projector &proj = S.proj;
+    float W = proj.cx * 2.f, H = proj.cy * 2.f;
+    float xMin = (-marginPx - proj.cx) / proj.scale, xMax = (W + marginPx - proj.cx) / proj.scale;
+    float yMin = (-marginPx - proj.cy) / proj.scale, yMax = (H + marginPx - proj.cy) / proj.scale;
+
+    Frustum Fr;
+    if (!proj.perspective) {
+        Mat4 R = Mat4::Rx(proj.ax) * Mat4::Ry(proj.ay);
+        Vec3 ax{R.m[0][0], R.m[1][0], R.m[2][0]};
+        Vec3 ay{R.m[0][1], R.m[1][1], R.m[2][1]};
+        Fr.add(ax, -xMin);
+        Fr.add(ax * -1.f, xMax);
+        Fr.add(ay, -yMin);
+        Fr.add(ay * -1.f, yMax);
+        return Fr;
+    }
+
+    Vec3 eye{0.f, 0.f, -proj.f}, right{1.f, 0.f, 0.f}, up{0.f, 1.f, 0.f}, fwd{0.f, 0.f, 1.f};
+    if (S.useCamera) {
+        fwd = norm(S.camera.target - S.camera.pos);
+        if (vlen(fwd) < 1e-6f) return Fr;
+        up = S.camera.up;
+        if (vlen(up) < 1e-6f) up = {0.f, 1.f, 0.f};
+        right = norm(cross(fwd, up));
+        if (vlen(right) < 1e-6f) {
+            up = {0.f, 1.f, 0.f};
+            right = norm(cross(fwd, up));
+        }
+        up = cross(right, fwd);
+        eye = S.camera.pos;
+    }
+
+    // x_cam / z_cam in [xMin, xMax], same for y; every side plane passes through the eye.
+    Vec3 nLeft = right - fwd * xMin, nRight = fwd * xMax - right;
+    Vec3 nBottom = up - fwd * yMin, nTop = fwd * yMax - up;
+    Fr.add(nLeft, -dot(nLeft, eye));
+    Fr.add(nRight, -dot(nRight, eye));
+    Fr.add(nBottom, -dot(nBottom, eye));
+    Fr.add(nTop, -dot(nTop, eye));
+    Fr.add(fwd, -dot(fwd, eye) - 1e-3f);
+    return Fr;
+}
+
+static CullResult classifySphere(const Frustum &Fr, const BoundingSphere &s) {
+    CullResult r = CullResult::Inside;
+    for (int i = 0; i < Fr.count; ++i) {
+        float d = Fr.planes[i].dist(s.center);
+        if (d < -s.radius) return CullResult::Outside;
+        if (d < s.radius) r = CullResult::Intersect;
+    }
+    return r;
+}
+
+static CullResult classifyBox(const Frustum &Fr, const Vec3 &c, const Vec3 &e) {
+    CullResult r = CullResult::Inside;
+    for (int i = 0; i < Fr.count; ++i) {
+        const Plane &P = Fr.planes[i];
+        float d = P.dist(c);
+        float reach = std::fabs(P.n.x) * e.x + std::fabs(P.n.y) * e.y + std::fabs(P.n.z) * e.z;
+        if (d < -reach) return CullResult::Outside;
+        if (d < reach) r = CullResult::Intersect;
+    }
+    return r;
+}
+
+// Upper bound of how much the model matrix can stretch a radius.
+static float maxScale(const Mat4 &M) {
+    Vec3 r0{M.m[0][0], M.m[0][1], M.m[0][2]};
+    Vec3 r1{M.m[1][0], M.m[1][1], M.m[1][2]};
+    Vec3 r2{M.m[2][0], M.m[2][1], M.m[2][2]};
+    float l0 = dot(r0, r0), l1 = dot(r1, r1), l2 = dot(r2, r2);
+    float tol = 1e-4f * (l0 + l1 + l2);
+    bool orthogonal = std::fabs(dot(r0, r1)) <= tol && std::fabs(dot(r0, r2)) <= tol && std::fabs(dot(r1, r2)) <= tol;
+    if (orthogonal) return std::sqrt(std::max({l0, l1, l2}));
+    return std::sqrt(l0 + l1 + l2);
+}
+
+// Hierarchical frustum test: mesh sphere -> mesh box -> face cluster spheres.
+// Returns false when nothing of the mesh can reach the screen. Otherwise clusterVisible is either
+// left empty (every face has to be drawn) or holds one flag per FACES_PER_CLUSTER faces.
+static bool cullMesh(const Mesh &mesh, const Mat4 &model, const AppState &S, vector<char> &clusterVisible) {
+    ScopedTimer timer(ProfStage::Cull);
+    clusterVisible.clear();
+    MeshBounds local;
+    const MeshBounds &B = mesh.bounds.valid ? mesh.bounds : (local = computeBounds(mesh));
+    CullStats &st = S.cullStats;
+    st.objectsTested++;
+    st.trianglesTested += B.triCount;
+    frameCounters().trianglesIn += B.triCount;
+
+    if (!S.frustumCull || !B.valid) return true;
+
+    Frustum Fr = buildFrustum(S);
+    float k = maxScale(model);
+    BoundingSphere ws{xform(B.sphere.center, model), B.sphere.radius * k};
+    CullResult res = classifySphere(Fr, ws);
+    if (res == CullResult::Intersect) {
+        Vec3 c = (B.box.min + B.box.max) * 0.5f, e = (B.box.max - B.box.min) * 0.5f;
+        Vec3 we{
+                std::fabs(model.m[0][0]) * e.x + std::fabs(model.m[1][0]) * e.y + std::fabs(model.m[2][0]) * e.z,
+                std::fabs(model.m[0][1]) * e.x + std::fabs(model.m[1][1]) * e.y + std::fabs(model.m[2][1]) * e.z,
+                std::fabs(model.m[0][2]) * e.x + std::fabs(model.m[1][2]) * e.y + std::fabs(model.m[2][2]) * e.z};
+        res = classifyBox(Fr, xform(c, model), we);
+    }
+    if (res == CullResult::Outside) {
+        st.objectsCulled++;
+        st.trianglesCulled += B.triCount;
+        frameCounters().trianglesCulled += B.triCount;
+        return false;
+    }
+    if (res == CullResult::Inside || B.clusters.size() < 2) return true;
+
+    bool any = false;
+    clusterVisible.resize(B.clusters.size());
+    for (size_t i = 0; i < B.clusters.size(); ++i) {
+        const FaceCluster &C = B.clusters[i];
+        BoundingSphere cs{xform(C.sphere.center, model), C.sphere.radius * k};
+        clusterVisible[i] = classifySphere(Fr, cs) != CullResult::Outside;
+        if (clusterVisible[i]) any = true;
+        else {
+            st.trianglesCulled += C.triCount;
+            frameCounters().trianglesCulled += C.triCount;
+        }
+    }
+    if (!any) st.objectsCulled++;
+    return any;
+}
+
+inline bool faceVisible(const vector<char> &clusterVisible, size_t fi) {
+    return clusterVisible.empty() || clusterVisible[fi / FACES_PER_CLUSTER];
+}
+
+static void drawCullStats(AppState &S) {
+    ImGui::SeparatorText("Frustum culling");
+    ImGui::Checkbox("Frustum culling", &S.frustumCull);
+    const CullStats &st = S.cullStats;
+    ImGui::Text("Objects culled: %d / %d", st.objectsCulled, st.objectsTested);
+    ImGui::Text("Triangles culled: %d / %d", st.trianglesCulled, st.trianglesTested);
+}
+
+
+static bool lodReady(const LodCacheEntry &e) {
+    return e.chain.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+// Returns the cache entry of the mesh, starting a background build of its chain on a miss. When the
+// cache is full the least recently used finished chain is dropped; chains still being built stay.
+static LodCacheEntry &requestLod(const Mesh &base, const AppState &S) {
+    auto it = S.lodCache.find(base.bounds.version);
+    if (it == S.lodCache.end()) {
+        if (S.lodCache.size() >= LOD_CACHE_SIZE) {
+            auto victim = S.lodCache.end();
+            for (auto e = S.lodCache.begin(); e != S.lodCache.end(); ++e)
+                if (lodReady(e->second) && (victim == S.lodCache.end() || e->second.lastUse < victim->second.lastUse))
+                    victim = e;
+            if (victim != S.lodCache.end()) S.lodCache.erase(victim);
+        }
+        LodCacheEntry entry;
+        entry.chain = std::async(std::launch::async, [mesh = base]() { return buildLodChain(mesh); }).share();
+        it = S.lodCache.emplace(base.bounds.version, std::move(entry)).first;
+    }
+    it->second.lastUse = ++S.lodClock;
+    return it->second;
+}
+
+// Blocks until the chain of the mesh is built; for callers that cannot draw the full mesh meanwhile.
+static void waitForLod(const Mesh &base, const AppState &S) {
+    if (!S.useLod || !base.bounds.valid || base.bounds.triCount < LOD_MIN_TRIANGLES * 2) return;
+    requestLod(base, S).chain.wait();
+}
+
+// Screen pixels per object-space unit around world point p for the current projection.
+static float pixelsPerUnit(const AppState &S, const Vec3 &p, float radius) {
+    const Projector &proj = S.proj;
+    if (!proj.perspective) return proj.scale;
+    float z;
+    if (S.useCamera) z = dot(p - S.camera.pos, norm(S.camera.target - S.camera.pos));
+    else z = proj.f + p.z;
+    z -= radius;
+    if (z <= 1e-3f) return 1e30f;
+    return proj.scale / z;
+}
+
+// Picks the coarsest level whose error stays below lodErrorPx on screen, then keeps going coarser
+// while the level has more triangles than its projected area can show (lodTriAreaPx per triangle).
+static const Mesh &selectLod(const Mesh &base, const Mat4 &model, const AppState &S) {
+    S.lodLevel = 0;
+    S.lodLevels = 1;
+    S.lodTriangles = base.bounds.triCount;
+    if (!S.useLod || !base.bounds.valid || base.bounds.triCount < LOD_MIN_TRIANGLES * 2) return base;
+
+    // The full mesh is drawn until the background build finishes.
+    const LodCacheEntry &entry = requestLod(base, S);
+    if (!lodReady(entry)) return base;
+    const LodChain &chain = entry.chain.get();
+
+    float k = maxScale(model);
+    float ppu = pixelsPerUnit(S, xform(base.bounds.sphere.center, model), base.bounds.sphere.radius * k) * k;
+    int level = 0;
+    for (int i = (int) chain.levels.size() - 1; i > 0; --i)
+        if (chain.levels[i].error * ppu <= S.lodErrorPx) {
+            level = i;
+            break;
+        }
+    float rPx = base.bounds.sphere.radius * ppu;
+    float budget = std::max((float) LOD_MIN_TRIANGLES, PI * rPx * rPx / std::max(S.lodTriAreaPx, 0.1f));
+    while (level + 1 < (int) chain.levels.size() && chain.levels[level].triCount > budget) level++;
+
+    S.lodLevel = level;
+    S.lodLevels = (int) chain.levels.size();
+    S.lodTriangles = chain.levels[level].triCount;
+    return chain.levels[level].mesh;
+}
+
+static void drawLodControls(AppState &S) {
+    ImGui::SeparatorText("Level of detail");
+    ImGui::Checkbox("Use LOD", &S.useLod);
+    ImGui::SliderFloat("Max error (px)", &S.lodErrorPx, 0.25f, 8.f);
+    ImGui::SliderFloat("Pixels per triangle", &S.lodTriAreaPx, 0.5f, 32.f);
+    ImGui::Text("Level %d / %d, triangles: %d", S.lodLevel, S.lodLevels - 1, S.lodTriangles);
+}
+
+static void drawAxes(RenderTarget &rt, const AppState &S, float len = 250.f) {
     Vec3 O{0, 0, 0}, X{len, 0, 0}, Y{0, len, 0}, Z{0, 0, len};
     int ox, oy, xx, xy, yx, yy, zx, zy;
     if (projectPoint(S, O, ox, oy) && projectPoint(S, X, xx, xy))
-        dl->AddLine(ImVec2(ox, oy), ImVec2(xx, xy), IM_COL32(255, 0, 0, 255), 2.f);
+        rt.line(ox, oy, xx, xy, IM_COL32(255, 0, 0, 255), 2.f);
     if (projectPoint(S, O, ox, oy) && projectPoint(S, Y, yx, yy))
-        dl->AddLine(ImVec2(ox, oy), ImVec2(yx, yy), IM_COL32(0, 200, 0, 255), 2.f);
+        rt.line(ox, oy, yx, yy, IM_COL32(0, 200, 0, 255), 2.f);
     if (projectPoint(S, O, ox, oy) && projectPoint(S, Z, zx, zy))
-        dl->AddLine(ImVec2(ox, oy), ImVec2(zx, zy), IM_COL32(0, 128, 255, 255), 2.f);
-    ImGui::GetForegroundDrawList()->AddText(ImVec2((float) xx, (float) xy), IM_COL32(255, 0, 0, 255), "X");
-    ImGui::GetForegroundDrawList()->AddText(ImVec2((float) yx, (float) yy), IM_COL32(0, 200, 0, 255), "Y");
-    ImGui::GetForegroundDrawList()->AddText(ImVec2((float) zx, (float) zy), IM_COL32(0, 128, 255, 255), "Z");
+        rt.line(ox, oy, zx, zy, IM_COL32(0, 128, 255, 255), 2.f);
+    rt.text((float) xx, (float) xy, IM_COL32(255, 0, 0, 255), "X");
+    rt.text((float) yx, (float) yy, IM_COL32(0, 200, 0, 255), "Y");
+    rt.text((float) zx, (float) zy, IM_COL32(0, 128, 255, 255), "Z");
+}
+
+static void drawAxes(const AppState &S, float len = 250.f) {
+    ImGuiTarget rt;
+    drawAxes(rt, S, len);
 }
 
 
@@ -671,14 +1271,13 @@ static inline float quantizeToon(float x, int levels) {
     return (float) bucket * step;
 }
 
-static void rasterTriangleGouraud(ImDrawList *dl,
+static void rasterTriangleGouraud(RenderTarget &rt,
                                   const ShadedVertex &v0,
                                   const ShadedVertex &v1,
                                   const ShadedVertex &v2,
                                   const AppState &S) {
-    ImVec2 disp = ImGui::GetIO().DisplaySize;
-    int screenW = (int) disp.x;
-    int screenH = (int) disp.y;
+    int screenW = rt.width();
+    int screenH = rt.height();
 
     float x0 = (float) v0.x, y0 = (float) v0.y;
     float x1 = (float) v1.x, y1 = (float) v1.y;
@@ -697,6 +1296,7 @@ static void rasterTriangleGouraud(ImDrawList *dl,
     float denom = ((y1 - y2) * (x0 - x2) + (x2 - x1) * (y0 - y2));
     if (std::fabs(denom) < 1e-6f) return;
     float invDen = 1.0f / denom;
+    int64_t shaded = 0;
 
     for (int y = minY; y <= maxY; ++y) {
         for (int x = minX; x <= maxX; ++x) {
@@ -708,26 +1308,25 @@ static void rasterTriangleGouraud(ImDrawList *dl,
             float w2 = 1.0f - w0 - w1;
 
             if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+            shaded++;
 
             float diff = w0 * v0.diffuse + w1 * v1.diffuse + w2 * v2.diffuse;
             float I = S.ambientK + (1.0f - S.ambientK) * diff;
             ImU32 col = shadeColor(S, I);
 
-            dl->AddRectFilled(ImVec2((float) x, (float) y),
-                              ImVec2((float) x + 1.0f, (float) y + 1.0f),
-                              col);
+            rt.pixel(x, y, col);
         }
     }
+    frameCounters().fragmentsShaded += shaded;
 }
 
-static void rasterTrianglePhongToon(ImDrawList *dl,
+static void rasterTrianglePhongToon(RenderTarget &rt,
                                     const ShadedVertex &v0,
                                     const ShadedVertex &v1,
                                     const ShadedVertex &v2,
                                     const AppState &S) {
-    ImVec2 disp = ImGui::GetIO().DisplaySize;
-    int screenW = (int) disp.x;
-    int screenH = (int) disp.y;
+    int screenW = rt.width();
+    int screenH = rt.height();
 
     float x0 = (float) v0.x, y0 = (float) v0.y;
     float x1 = (float) v1.x, y1 = (float) v1.y;
@@ -746,6 +1345,7 @@ static void rasterTrianglePhongToon(ImDrawList *dl,
     float denom = ((y1 - y2) * (x0 - x2) + (x2 - x1) * (y0 - y2));
     if (std::fabs(denom) < 1e-6f) return;
     float invDen = 1.0f / denom;
+    int64_t shaded = 0;
 
     for (int y = minY; y <= maxY; ++y) {
         for (int x = minX; x <= maxX; ++x) {
@@ -757,6 +1357,7 @@ static void rasterTrianglePhongToon(ImDrawList *dl,
             float w2 = 1.0f - w0 - w1;
 
             if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+            shaded++;
             Vec3 P = v0.worldPos * w0 + v1.worldPos * w1 + v2.worldPos * w2;
             Vec3 N = norm(v0.normal * w0 + v1.normal * w1 + v2.normal * w2);
 
@@ -767,22 +1368,20 @@ static void rasterTrianglePhongToon(ImDrawList *dl,
             float I = S.ambientK + (1.0f - S.ambientK) * toon;
 
             ImU32 col = shadeColor(S, I);
-            dl->AddRectFilled(ImVec2((float) x, (float) y),
-                              ImVec2((float) x + 1.0f, (float) y + 1.0f),
-                              col);
+            rt.pixel(x, y, col);
         }
     }
+    frameCounters().fragmentsShaded += shaded;
 }
 
-static void rasterTriangleTextured(ImDrawList *dl,
+static void rasterTriangleTextured(RenderTarget &rt,
                                    const ShadedVertex &v0,
                                    const ShadedVertex &v1,
                                    const ShadedVertex &v2,
                                    const AppState &S,
                                    const Texture &tex) {
-    ImVec2 disp = ImGui::GetIO().DisplaySize;
-    int screenW = (int) disp.x;
-    int screenH = (int) disp.y;
+    int screenW = rt.width();
+    int screenH = rt.height();
 
     float x0 = (float) v0.x, y0 = (float) v0.y;
     float x1 = (float) v1.x, y1 = (float) v1.y;
@@ -801,6 +1400,7 @@ static void rasterTriangleTextured(ImDrawList *dl,
     float denom = ((y1 - y2) * (x0 - x2) + (x2 - x1) * (y0 - y2));
     if (std::fabs(denom) < 1e-6f) return;
     float invDen = 1.0f / denom;
+    int64_t shaded = 0;
 
     for (int y = minY; y <= maxY; ++y) {
         for (int x = minX; x <= maxX; ++x) {
@@ -812,6 +1412,7 @@ static void rasterTriangleTextured(ImDrawList *dl,
             float w2 = 1.0f - w0 - w1;
 
             if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+            shaded++;
 
             float u = w0 * v0.u + w1 * v1.u + w2 * v2.u;
             float v = w0 * v0.v + w1 * v1.v + w2 * v2.v;
@@ -826,18 +1427,18 @@ static void rasterTriangleTextured(ImDrawList *dl,
 
             ImU32 col = shadeTextured(texColor, I);
 
-            dl->AddRectFilled(ImVec2((float) x, (float) y),
-                              ImVec2((float) x + 1.0f, (float) y + 1.0f),
-                              col);
+            rt.pixel(x, y, col);
         }
     }
+    frameCounters().fragmentsShaded += shaded;
 }
 
 
+// Draws the faces left visible by an earlier cullMesh call on the same mesh and model. countTriangles is
+// false for an overlay over faces another pass has already counted.
 static void
-drawWireImGui(const Mesh &base, const Mat4 &model, const AppState &S, ImU32 color = IM_COL32(20, 20, 20, 255),
-              float thick = 1.8f) {
-    ImDrawList *dl = ImGui::GetBackgroundDrawList();
+drawWire(RenderTarget &rt, const Mesh &base, const Mat4 &model, const AppState &S, const vector<char> &clusterVisible,
+         ImU32 color, float thick, bool countTriangles) {
     Vec3 viewDirWorld{0, 0, 1};
     if (S.proj.perspective) {
         Vec3 cam{0.f, 0.f, -S.proj.f};
@@ -848,12 +1449,22 @@ drawWireImGui(const Mesh &base, const Mat4 &model, const AppState &S, ImU32 colo
         viewDirWorld = norm(Vec3{r.x, r.y, r.z});
     }
 
+    // Back-face tests are booked as cull, emitting the lines as raster.
+    ScopedTimer cullTimer(ProfStage::Cull);
+    struct WireFace {
+        size_t fi;
+        bool drawn;
+        Vec3 fc, n;
+    };
+    vector<WireFace> faces;
+
     Vec3 meshC_object = centroid(base);
     Vec3 meshC = xform(meshC_object, model);
     const float EPS = 1e-6f;
 
-    for (const auto &f: base.F) {
-        if (f.idx.size() < 3) continue;
+    for (size_t fi = 0; fi < base.F.size(); ++fi) {
+        const auto &f = base.F[fi];
+        if (f.idx.size() < 3 || !faceVisible(clusterVisible, fi)) continue;
 
         Vec3 a = xform({base.V[f.idx[0]].x, base.V[f.idx[0]].y, base.V[f.idx[0]].z}, model);
         Vec3 b = xform({base.V[f.idx[1]].x, base.V[f.idx[1]].y, base.V[f.idx[1]].z}, model);
@@ -888,44 +1499,71 @@ drawWireImGui(const Mesh &base, const Mat4 &model, const AppState &S, ImU32 colo
 
 
         bool frontFacing = dot(n, viewDir) > EPS;
+        bool drawn = !S.backfaceCull || frontFacing;
 
-        if (!S.backfaceCull || frontFacing) {
+        if (countTriangles) {
+            if (drawn) frameCounters().trianglesRasterized += (int) f.idx.size() - 2;
+            else frameCounters().trianglesCulled += (int) f.idx.size() - 2;
+        }
+        if (drawn || S.showFaceNormals) faces.push_back({fi, drawn, fc, n});
+    }
+    cullTimer.stop();
+
+    ScopedTimer rasterTimer(ProfStage::Raster);
+    for (const auto &wf: faces) {
+        const auto &f = base.F[wf.fi];
+        if (wf.drawn) {
             for (size_t i = 0; i < f.idx.size(); ++i) {
                 int i0 = f.idx[i], i1 = f.idx[(i + 1) % f.idx.size()];
                 Vec3 va = xform({base.V[i0].x, base.V[i0].y, base.V[i0].z}, model);
                 Vec3 vb = xform({base.V[i1].x, base.V[i1].y, base.V[i1].z}, model);
                 int x0, y0, x1, y1;
                 if (projectPoint(S, va, x0, y0) && projectPoint(S, vb, x1, y1)) {
-                    dl->AddLine(ImVec2((float) x0, (float) y0),
-                                ImVec2((float) x1, (float) y1),
-                                color, thick);
+                    rt.line((float) x0, (float) y0, (float) x1, (float) y1, color, thick);
                 }
 
             }
         }
 
         if (S.showFaceNormals) {
-            Vec3 nstart = fc;
-            Vec3 nend = fc + n * 30.f;
+            Vec3 nstart = wf.fc;
+            Vec3 nend = wf.fc + wf.n * 30.f;
             int xs, ys, xe, ye;
             if (projectPoint(S, nstart, xs, ys) && projectPoint(S, nend, xe, ye)) {
-                dl->AddLine(ImVec2((float) xs, (float) ys), ImVec2((float) xe, (float) ye), IM_COL32(200, 30, 30, 255),
-                            1.2f);
+                rt.line((float) xs, (float) ys, (float) xe, (float) ye, IM_COL32(200, 30, 30, 255), 1.2f);
             }
         }
     }
 }
 
-static void drawShadedImGui(const Mesh &base, const Mat4 &model, const AppState &S) {
-    ImDrawList *dl = ImGui::GetBackgroundDrawList();
+static void
+drawWire(RenderTarget &rt, const Mesh &base, const Mat4 &model, const AppState &S,
+         ImU32 color = IM_COL32(20, 20, 20, 255), float thick = 1.8f) {
+    vector<char> clusterVisible;
+    if (!cullMesh(base, model, S, clusterVisible)) return;
+    drawWire(rt, base, model, S, clusterVisible, color, thick, true);
+}
+
+static void
+drawWireImGui(const Mesh &base, const Mat4 &model, const AppState &S, ImU32 color = IM_COL32(20, 20, 20, 255),
+              float thick = 1.8f) {
+    ImGuiTarget rt;
+    drawWire(rt, base, model, S, color, thick);
+}
+
+static void drawShaded(RenderTarget &rt, const Mesh &base, const Mat4 &model, const AppState &S) {
     if (S.shadingMode == 0) {
-        drawWireImGui(base, model, S, IM_COL32(20, 20, 20, 255), 1.8f);
+        drawWire(rt, base, model, S, IM_COL32(20, 20, 20, 255), 1.8f);
         return;
     }
 
     int nV = (int) base.V.size();
     if (nV == 0) return;
 
+    vector<char> clusterVisible;
+    if (!cullMesh(base, model, S, clusterVisible)) return;
+
+    ScopedTimer transformTimer(ProfStage::Transform);
     vector<Vec3> worldPos(nV);
     vector<Vec3> vNormals(nV, Vec3{0, 0, 0});
     vector<int> sx(nV), sy(nV);
@@ -936,6 +1574,9 @@ static void drawShadedImGui(const Mesh &base, const Mat4 &model, const AppState
         worldPos[i] = xform({v.x, v.y, v.z}, model);
         visible[i] = projectPoint(S, worldPos[i], sx[i], sy[i]);
     }
+    transformTimer.stop();
+
+    ScopedTimer shadeTimer(ProfStage::Shade);
 
     for (const auto &f: base.F) {
         if (f.idx.size() < 3) continue;
@@ -979,6 +1620,7 @@ static void drawShadedImGui(const Mesh &base, const Mat4 &model, const AppState
         vUV[i].u = (p.x - minX) * invDX;
         vUV[i].v = (p.y - minY) * invDY;
     }
+    shadeTimer.stop();
 
     Vec3 meshC_object = centroid(base);
     Vec3 meshC = xform(meshC_object, model);
@@ -992,8 +1634,13 @@ static void drawShadedImGui(const Mesh &base, const Mat4 &model, const AppState
     }
     const float EPS = 1e-6f;
 
-    for (const auto &f: base.F) {
-        if (f.idx.size() < 3) continue;
+    // Back-face and projection tests first, booked as cull; the surviving triangles are then
+    // rasterized in one timed batch.
+    ScopedTimer cullTimer(ProfStage::Cull);
+    vector<std::array<int, 3>> tris;
+    for (size_t fi = 0; fi < base.F.size(); ++fi) {
+        const auto &f = base.F[fi];
+        if (f.idx.size() < 3 || !faceVisible(clusterVisible, fi)) continue;
 
         Vec3 fc{0, 0, 0};
         for (int vidx: f.idx) {
@@ -1022,37 +1669,55 @@ static void drawShadedImGui(const Mesh &base, const Mat4 &model, const AppState
         }
 
         bool frontFacing = dot(n, viewDir) > EPS;
-        if (S.backfaceCull && !frontFacing) continue;
+        if (S.backfaceCull && !frontFacing) {
+            frameCounters().trianglesCulled += (int) f.idx.size() - 2;
+            continue;
+        }
 
         for (size_t t = 1; t + 1 < f.idx.size(); ++t) {
             int i0 = f.idx[0];
             int i1 = f.idx[t];
             int i2 = f.idx[t + 1];
 
-            if (!visible[i0] || !visible[i1] || !visible[i2]) continue;
-
-            ShadedVertex sv0{sx[i0], sy[i0], worldPos[i0], vNormals[i0], vDiffuse[i0]};
-            ShadedVertex sv1{sx[i1], sy[i1], worldPos[i1], vNormals[i1], vDiffuse[i1]};
-            ShadedVertex sv2{sx[i2], sy[i2], worldPos[i2], vNormals[i2], vDiffuse[i2]};
-
-            sv0.u = vUV[i0].u;
-            sv0.v = vUV[i0].v;
-            sv1.u = vUV[i1].u;
-            sv1.v = vUV[i1].v;
-            sv2.u = vUV[i2].u;
-            sv2.v = vUV[i2].v;
-
-            if (S.shadingMode == 1) {
-                rasterTriangleGouraud(dl, sv0, sv1, sv2, S);
-            } else if (S.shadingMode == 2) {
-                rasterTrianglePhongToon(dl, sv0, sv1, sv2, S);
-            } else if (S.shadingMode == 3) {
-                rasterTriangleTextured(dl, sv0, sv1, sv2, S, S.texture);
+            if (!visible[i0] || !visible[i1] || !visible[i2]) {
+                frameCounters().trianglesCulled++;
+                continue;
             }
+            tris.push_back({i0, i1, i2});
+        }
+    }
+    cullTimer.stop();
+
+    ScopedTimer rasterTimer(ProfStage::Raster);
+    frameCounters().trianglesRasterized += (int64_t) tris.size();
+    for (const auto &t: tris) {
+        int i0 = t[0], i1 = t[1], i2 = t[2];
+        ShadedVertex sv0{sx[i0], sy[i0], worldPos[i0], vNormals[i0], vDiffuse[i0]};
+        ShadedVertex sv1{sx[i1], sy[i1], worldPos[i1], vNormals[i1], vDiffuse[i1]};
+        ShadedVertex sv2{sx[i2], sy[i2], worldPos[i2], vNormals[i2], vDiffuse[i2]};
+
+        sv0.u = vUV[i0].u;
+        sv0.v = vUV[i0].v;
+        sv1.u = vUV[i1].u;
+        sv1.v = vUV[i1].v;
+        sv2.u = vUV[i2].u;
+        sv2.v = vUV[i2].v;
+
+        if (S.shadingMode == 1) {
+            rasterTriangleGouraud(rt, sv0, sv1, sv2, S);
+        } else if (S.shadingMode == 2) {
+            rasterTrianglePhongToon(rt, sv0, sv1, sv2, S);
+        } else if (S.shadingMode == 3) {
+            rasterTriangleTextured(rt, sv0, sv1, sv2, S, S.texture);
         }
     }
 }
 
+static void drawShadedImGui(const Mesh &base, const Mat4 &model, const AppState &S) {
+    ImGuiTarget rt;
+    drawShaded(rt, base, model, S);
+}
+
 
 static bool openObject(const string &filename, AppState &appState, Mesh &mesh) {
     mesh.V.clear();
@@ -1126,6 +1791,7 @@ static bool openObject(const string &filename, AppState &appState, Mesh &mesh) {
         }
     }
     file.close();
+    updateBounds(mesh);
     filesystem::path filepath(filename);
     string objName = filepath.filename().string();
     appState.meshesNames.push_back(objName);
@@ -1303,6 +1969,7 @@ inline int run_lab_6() {
 
     while (!glfwWindowShouldClose(win)) {
         glfwPollEvents();
+        FrameProfiler::instance().beginFrame();
         applyKeyOps(win, S);
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -1361,6 +2028,9 @@ inline int run_lab_6() {
         }
 
 
+        drawCullStats(S);
+        drawLodControls(S);
+
         ImGui::SeparatorText("Lighting");
         const char *shadingItems[] = {"Wireframe", "Gouraud (Lambert)", "Phong toon", "Textured"};
         ImGui::Combo("Shading", &S.shadingMode, shadingItems, IM_ARRAYSIZE(shadingItems));
@@ -1444,6 +2114,7 @@ inline int run_lab_6() {
             }
         }
         ImGui::End();
+        FrameProfiler::instance().drawOverlay();
 
         saveFileDialog.Display();
         if (saveFileDialog.HasSelected()) {
@@ -1466,18 +2137,23 @@ inline int run_lab_6() {
         S.proj.cx = ImGui::GetIO().DisplaySize.x * 0.5f;
         S.proj.cy = ImGui::GetIO().DisplaySize.y * 0.5f;
         if (showAxes) drawAxes(S, 250.f);
+        S.cullStats = {};
+        const Mesh &lodMesh = selectLod(S.base, S.modelMat, S);
         if (S.shadingMode == 0) {
-            drawWireImGui(S.base, S.modelMat, S, IM_COL32(20, 20, 20, 255), 1.8f);
+            drawWireImGui(lodMesh, S.modelMat, S, IM_COL32(20, 20, 20, 255), 1.8f);
         } else {
-            drawShadedImGui(S.base, S.modelMat, S);
+            drawShadedImGui(lodMesh, S.modelMat, S);
         }
         int fbw, fbh;
         glfwGetFramebufferSize(win, &fbw, &fbh);
+        ScopedTimer submitTimer(ProfStage::Submit);
         ImGui::Render();
         glViewport(0, 0, fbw, fbh);
         glClearColor(0.96f, 0.96f, 0.96f, 1.f);
         glClear(GL_COLOR_BUFFER_BIT);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        submitTimer.stop();
+        FrameProfiler::instance().endFrame();
         glfwSwapBuffers(win);
     }
     ImGui_ImplOpenGL3_Shutdown();
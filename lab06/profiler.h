@@ -0,0 +1,239 @@
+#ifndef CS332_PROFILER_H
+#define CS332_PROFILER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <imgui.h>
+
+// Per-stage frame profiler for the software renderer (lab06/lab07).
+//
+//   Transform - model transform and projection of vertices
+//   Cull      - frustum and back-face tests
+//   Shade     - per-vertex lighting setup (normals, diffuse, UV)
+//   Raster    - triangle/line coverage loops, including per-fragment shading and draw list appends
+//   Submit    - ImGui::Render + handing the draw data to OpenGL
+//
+// Time not covered by any stage (UI, bookkeeping) shows up as "Other".
+
+enum class ProfStage {
+    Transform = 0, Cull, Shade, Raster, Submit, Count
+};
+
+inline const char *profStageName(ProfStage s) {
+    static const char *names[] = {"Transform", "Cull", "Shade", "Raster", "Submit"};
+    return names[(int) s];
+}
+
+struct FrameCounters {
+    int64_t trianglesIn{};
+    int64_t trianglesCulled{};
+    int64_t trianglesRasterized{};
+    int64_t fragmentsShaded{};
+    int64_t depthRejected{};
+};
+
+class FrameProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int HISTORY = 240;
+    static constexpr size_t MAX_TRACE_EVENTS = 500000;
+
+    static FrameProfiler &instance() {
+        static FrameProfiler profiler;
+        return profiler;
+    }
+
+    bool enabled = true;
+    bool recording = false;
+    FrameCounters counters;
+
+    void beginFrame() {
+        frameStart = Clock::now();
+        stageNs.fill(0);
+        counters = {};
+    }
+
+    void endFrame() {
+        int64_t total = nsSince(frameStart);
+        int64_t covered = 0;
+        for (int s = 0; s < STAGES; ++s) {
+            history[s][cursor] = (float) stageNs[s] * 1e-6f;
+            covered += stageNs[s];
+        }
+        history[STAGES][cursor] = (float) std::max<int64_t>(0, total - covered) * 1e-6f;
+        frameMs[cursor] = (float) total * 1e-6f;
+        lastCounters = counters;
+        cursor = (cursor + 1) % HISTORY;
+        if (recording) {
+            traceCounter(frameStart);
+            frameIndex++;
+        }
+    }
+
+    void addStage(ProfStage s, Clock::time_point begin, Clock::time_point end) {
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+        stageNs[(int) s] += ns;
+        if (recording) traceSpan(s, begin, end);
+    }
+
+    // Writes the recorded spans as a Chrome trace (chrome://tracing, Perfetto).
+    bool exportChromeTrace(const std::string &path) const {
+        std::ofstream out(path);
+        if (!out.is_open()) return false;
+        out << "{\"traceEvents\":[\n";
+        bool first = true;
+        for (const auto &e: events) {
+            if (!first) out << ",\n";
+            first = false;
+            if (e.stage < 0) {
+                out << "{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":" << e.startUs
+                    << ",\"args\":{\"triangles_in\":" << e.counters.trianglesIn
+                    << ",\"triangles_culled\":" << e.counters.trianglesCulled
+                    << ",\"triangles_rasterized\":" << e.counters.trianglesRasterized
+                    << ",\"fragments_shaded\":" << e.counters.fragmentsShaded
+                    << ",\"depth_rejected\":" << e.counters.depthRejected << "}}";
+            } else {
+                out << "{\"name\":\"" << profStageName((ProfStage) e.stage)
+                    << "\",\"cat\":\"render\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << e.startUs
+                    << ",\"dur\":" << e.durUs << "}";
+            }
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        return true;
+    }
+
+    void clearTrace() {
+        events.clear();
+        frameIndex = 0;
+    }
+
+    void drawOverlay(bool *open = nullptr) {
+        ImGui::SetNextWindowBgAlpha(0.85f);
+        if (!ImGui::Begin("Frame profiler", open)) {
+            ImGui::End();
+            return;
+        }
+        ImGui::Checkbox("Enabled", &enabled);
+        int last = (cursor + HISTORY - 1) % HISTORY;
+        ImGui::Text("Frame: %.2f ms", frameMs[last]);
+
+        char overlay[64];
+        for (int s = 0; s <= STAGES; ++s) {
+            const char *name = s < STAGES ? profStageName((ProfStage) s) : "Other";
+            float peak = 0.f;
+            for (float v: history[s]) peak = std::max(peak, v);
+            snprintf(overlay, sizeof(overlay), "%s %.2f ms", name, history[s][last]);
+            ImGui::PlotHistogram(("##" + std::string(name)).c_str(), history[s].data(), HISTORY, cursor,
+                                 overlay, 0.f, std::max(peak, 0.5f), ImVec2(0, 36));
+        }
+
+        const FrameCounters &c = lastCounters;
+        ImGui::Text("Triangles in: %lld", (long long) c.trianglesIn);
+        ImGui::Text("Triangles culled: %lld", (long long) c.trianglesCulled);
+        ImGui::Text("Triangles rasterized: %lld", (long long) c.trianglesRasterized);
+        ImGui::Text("Fragments shaded: %lld", (long long) c.fragmentsShaded);
+        ImGui::Text("Depth rejected: %lld", (long long) c.depthRejected);
+
+        ImGui::SeparatorText("Chrome trace");
+        if (ImGui::Checkbox("Record", &recording) && recording) clearTrace();
+        ImGui::SameLine();
+        ImGui::Text("%d frames, %zu events", frameIndex, events.size());
+        static char tracePath[256] = "frame_trace.json";
+        ImGui::InputText("File", tracePath, IM_ARRAYSIZE(tracePath));
+        if (ImGui::Button("Export trace")) {
+            exportOk = exportChromeTrace(tracePath) ? 1 : -1;
+        }
+        if (exportOk != 0) {
+            ImGui::SameLine();
+            ImGui::TextUnformatted(exportOk > 0 ? "saved" : "failed to write");
+        }
+        ImGui::End();
+    }
+
+private:
+    static constexpr int STAGES = (int) ProfStage::Count;
+
+    struct TraceEvent {
+        int stage;  // -1 for a per-frame counter sample
+        int64_t startUs, durUs;
+        FrameCounters counters;
+    };
+
+    FrameProfiler() {
+        for (auto &h: history) h.fill(0.f);
+        frameMs.fill(0.f);
+        origin = Clock::now();
+    }
+
+    static int64_t nsSince(Clock::time_point t) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t).count();
+    }
+
+    int64_t usFromOrigin(Clock::time_point t) const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(t - origin).count();
+    }
+
+    // Back-to-back spans of the same stage (e.g. one per triangle) are merged into one event.
+    void traceSpan(ProfStage s, Clock::time_point begin, Clock::time_point end) {
+        int64_t b = usFromOrigin(begin), e = usFromOrigin(end);
+        if (!events.empty()) {
+            TraceEvent &prev = events.back();
+            if (prev.stage == (int) s && b - (prev.startUs + prev.durUs) <= 2) {
+                prev.durUs = std::max(prev.durUs, e - prev.startUs);
+                return;
+            }
+        }
+        if (events.size() >= MAX_TRACE_EVENTS) {
+            recording = false;
+            return;
+        }
+        events.push_back({(int) s, b, std::max<int64_t>(e - b, 0), {}});
+    }
+
+    void traceCounter(Clock::time_point t) {
+        if (events.size() >= MAX_TRACE_EVENTS) return;
+        events.push_back({-1, usFromOrigin(t), 0, counters});
+    }
+
+    Clock::time_point origin, frameStart;
+    std::array<int64_t, STAGES> stageNs{};
+    std::array<std::array<float, HISTORY>, STAGES + 1> history{};
+    std::array<float, HISTORY> frameMs{};
+    FrameCounters lastCounters;
+    int cursor = 0;
+    int frameIndex = 0;
+    int exportOk = 0;
+    std::vector<TraceEvent> events;
+};
+
+// Adds the lifetime of the object to the given stage of the current frame.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(ProfStage s) : stage(s), active(FrameProfiler::instance().enabled) {
+        if (active) begin = FrameProfiler::Clock::now();
+    }
+
+    ~ScopedTimer() { stop(); }
+
+    // Ends the measurement early, for stages that do not map onto a C++ scope.
+    void stop() {
+        if (active) FrameProfiler::instance().addStage(stage, begin, FrameProfiler::Clock::now());
+        active = false;
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    ProfStage stage;
+    bool active;
+    FrameProfiler::Clock::time_point begin;
+};
+
+inline FrameCounters &frameCounters() { return FrameProfiler::instance().counters; }
+
+#endif //CS332_PROFILER_H
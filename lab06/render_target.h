@@ -0,0 +1,112 @@
+#ifndef CS332_RENDER_TARGET_H
+#define CS332_RENDER_TARGET_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <imgui.h>
+
+// Where the software renderer puts its pixels and lines. The rasterizers only talk to this
+// interface, so the same code draws into the ImGui background list or into a plain framebuffer
+// without any ImGui context (headless benchmarks).
+struct RenderTarget {
+    virtual ~RenderTarget() = default;
+
+    virtual int width() const = 0;
+
+    virtual int height() const = 0;
+
+    virtual void pixel(int x, int y, ImU32 color) = 0;
+
+    virtual void line(float x0, float y0, float x1, float y1, ImU32 color, float thickness) = 0;
+
+    virtual void text(float /*x*/, float /*y*/, ImU32 /*color*/, const char * /*str*/) {}
+};
+
+// Draws into the ImGui background draw list of the current frame.
+struct ImGuiTarget : RenderTarget {
+    ImDrawList *dl;
+    int w, h;
+
+    ImGuiTarget() : dl(ImGui::GetBackgroundDrawList()),
+                    w((int) ImGui::GetIO().DisplaySize.x), h((int) ImGui::GetIO().DisplaySize.y) {}
+
+    int width() const override { return w; }
+
+    int height() const override { return h; }
+
+    void pixel(int x, int y, ImU32 color) override {
+        dl->AddRectFilled(ImVec2((float) x, (float) y), ImVec2((float) x + 1.0f, (float) y + 1.0f), color);
+    }
+
+    void line(float x0, float y0, float x1, float y1, ImU32 color, float thickness) override {
+        dl->AddLine(ImVec2(x0, y0), ImVec2(x1, y1), color, thickness);
+    }
+
+    void text(float x, float y, ImU32 color, const char *str) override {
+        ImGui::GetForegroundDrawList()->AddText(ImVec2(x, y), color, str);
+    }
+};
+
+// Offscreen RGBA framebuffer (ImU32 layout). Lines are 1px Bresenham; thickness is ignored.
+struct FramebufferTarget : RenderTarget {
+    int w, h;
+    std::vector<ImU32> pixels;
+
+    FramebufferTarget(int w, int h) : w(w), h(h), pixels((size_t) w * h, IM_COL32(245, 245, 245, 255)) {}
+
+    int width() const override { return w; }
+
+    int height() const override { return h; }
+
+    void clear(ImU32 color) { std::fill(pixels.begin(), pixels.end(), color); }
+
+    void pixel(int x, int y, ImU32 color) override {
+        if (x < 0 || y < 0 || x >= w || y >= h) return;
+        pixels[(size_t) y * w + x] = color;
+    }
+
+    void line(float x0f, float y0f, float x1f, float y1f, ImU32 color, float) override {
+        int x0 = (int) std::lround(x0f), y0 = (int) std::lround(y0f);
+        int x1 = (int) std::lround(x1f), y1 = (int) std::lround(y1f);
+        int dx = std::abs(x1 - x0), dy = -std::abs(y1 - y0);
+        int sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1;
+        int err = dx + dy;
+        while (true) {
+            pixel(x0, y0, color);
+            if (x0 == x1 && y0 == y1) break;
+            int e2 = 2 * err;
+            if (e2 >= dy) {
+                err += dy;
+                x0 += sx;
+            }
+            if (e2 <= dx) {
+                err += dx;
+                y0 += sy;
+            }
+        }
+    }
+
+    // Binary PPM (P6), alpha dropped.
+    bool writePPM(const std::string &path) const {
+        std::ofstream out(path, std::ios::binary);
+        if (!out.is_open()) return false;
+        out << "P6\n" << w << " " << h << "\n255\n";
+        std::vector<unsigned char> row((size_t) w * 3);
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                ImU32 c = pixels[(size_t) y * w + x];
+                row[x * 3 + 0] = (unsigned char) ((c >> IM_COL32_R_SHIFT) & 0xFF);
+                row[x * 3 + 1] = (unsigned char) ((c >> IM_COL32_G_SHIFT) & 0xFF);
+                row[x * 3 + 2] = (unsigned char) ((c >> IM_COL32_B_SHIFT) & 0xFF);
+            }
+            out.write((const char *) row.data(), (std::streamsize) row.size());
+        }
+        return true;
+    }
+};
+
+#endif //CS332_RENDER_TARGET_H
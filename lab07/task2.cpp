@@ -1,343 +1,98 @@
 ﻿#include "task2.h"
+#include "zbuffer.h"
 
 using std::vector;
 using std::string;
 
 namespace lab7 {
 
-#ifndef Z_BUFFER_H
-#define Z_BUFFER_H
-
-#include <vector>
-#include <limits>
-#include <algorithm>
-#include <cmath>
-#include <imgui.h>
-
-    static constexpr float INF = std::numeric_limits<float>::max();
-
-    struct ZBuffer {
-        int width, height;
-        std::vector<float> buffer;
-
-        ZBuffer(int w, int h) : width(w), height(h), buffer(w* h, INF) {}
-
-        void clear() {
-            std::fill(buffer.begin(), buffer.end(), INF);
+    // Splits [begin, end) into contiguous chunks, one per hardware thread; small ranges stay serial.
+    template <class Body>
+    static void parallelFor(int begin, int end, Body&& body, int minChunk = 64) {
+        int total = end - begin;
+        if (total <= 0) return;
+        int workers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        workers = std::min(workers, std::max(1, total / minChunk));
+        if (workers == 1) {
+            body(begin, end);
+            return;
         }
-
-        bool testAndSet(int x, int y, float z) {
-            if (x < 0 || x >= width || y < 0 || y >= height) return false;
-            int idx = y * width + x;
-            if (z < buffer[idx]) {
-                buffer[idx] = z;
-                return true;
-            }
-            return false;
+        vector<std::thread> threads;
+        threads.reserve(workers - 1);
+        int chunk = (total + workers - 1) / workers;
+        for (int w = 1; w < workers; ++w) {
+            int b = begin + w * chunk, e = std::min(end, b + chunk);
+            if (b < e) threads.emplace_back([&body, b, e] { body(b, e); });
         }
-    };
-
-    inline Vec3 computeFaceNormal(const Mesh& mesh, const Face& face, const Mat4& model) {
-        if (face.idx.size() < 3) return { 0, 0, 0 };
-
-        Vec3 v0 = xform({ mesh.V[face.idx[0]].x, mesh.V[face.idx[0]].y, mesh.V[face.idx[0]].z }, model);
-        Vec3 v1 = xform({ mesh.V[face.idx[1]].x, mesh.V[face.idx[1]].y, mesh.V[face.idx[1]].z }, model);
-        Vec3 v2 = xform({ mesh.V[face.idx[2]].x, mesh.V[face.idx[2]].y, mesh.V[face.idx[2]].z }, model);
-
-        Vec3 edge1 = v1 - v0;
-        Vec3 edge2 = v2 - v0;
-        return norm(cross(edge1, edge2));
+        body(begin, std::min(end, begin + chunk));
+        for (auto& t : threads) t.join();
     }
 
-    inline bool isFaceVisible(const Vec3& normal, const Vec3& viewDir) {
-        return dot(normal, viewDir) < 0;
-    }
-
-    static void rasterizeTriangle(ZBuffer& zBuffer, const std::vector<Vec3>& screenCoords,
-        const std::vector<float>& depths, ImU32 color, const AppState& S) {
-        int minX = S.proj.cx * 2, maxX = 0;
-        int minY = S.proj.cy * 2, maxY = 0;
-
-        for (const auto& p : screenCoords) {
-            minX = std::min(minX, (int)p.x);
-            maxX = std::max(maxX, (int)p.x);
-            minY = std::min(minY, (int)p.y);
-            maxY = std::max(maxY, (int)p.y);
-        }
-
-        minX = std::max(0, minX);
-        maxX = std::min(zBuffer.width - 1, maxX);
-        minY = std::max(0, minY);
-        maxY = std::min(zBuffer.height - 1, maxY);
-
-        const Vec3& v0 = screenCoords[0];
-        const Vec3& v1 = screenCoords[1];
-        const Vec3& v2 = screenCoords[2];
-
-        float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
-        if (std::abs(area) < 1e-6f) return;
-
-        float invArea = 1.0f / area;
-
-        ImDrawList* dl = ImGui::GetBackgroundDrawList();
-
-        for (int y = minY; y <= maxY; ++y) {
-            for (int x = minX; x <= maxX; ++x) {
-                float w0 = ((v1.x - x) * (v2.y - y) - (v2.x - x) * (v1.y - y)) * invArea;
-                float w1 = ((v2.x - x) * (v0.y - y) - (v0.x - x) * (v2.y - y)) * invArea;
-                float w2 = ((v0.x - x) * (v1.y - y) - (v1.x - x) * (v0.y - y)) * invArea;
-
-                if (w0 >= 0 && w1 >= 0 && w2 >= 0) {
-                    float z = w0 * depths[0] + w1 * depths[1] + w2 * depths[2];
-
-                    if (zBuffer.testAndSet(x, y, z)) {
-                        dl->AddRectFilled(ImVec2((float)x, (float)y),
-                            ImVec2((float)x + 1, (float)y + 1), color);
-                    }
-                }
-            }
+    // Surface of revolution of the generatrix. Generatrix points lying on the axis become a single
+    // shared pole vertex (fans of triangles instead of degenerate quads), cos/sin are tabulated
+    // once, and vertices and faces are written straight into preallocated buffers, split over
+    // angle slices between threads.
+    static Mesh buildRevolutionWelded(const vector<Vec3>& gen, char axis, int subdivisions) {
+        Mesh mesh;
+        if (gen.size() < 2 || subdivisions < 3) {
+            return mesh;
         }
-    }
-
-    static bool projectPointWithCamera(const AppState& S, const Vec3& pw, int& X, int& Y, float& depth) {
-        const Projector& proj = S.proj;
-
-        if (proj.perspective) {
-            if (S.useCamera) {
-                Vec3 fwd = norm(S.camera.target - S.camera.pos);
-                if (vlen(fwd) < 1e-6f) return false;
-
-                Vec3 up = S.camera.up;
-                if (vlen(up) < 1e-6f) up = { 0.f, 1.f, 0.f };
-
-                Vec3 right = norm(cross(fwd, up));
-                if (vlen(right) < 1e-6f) {
-                    up = { 0.f, 1.f, 0.f };
-                    right = norm(cross(fwd, up));
-                }
-                up = cross(right, fwd);
-
-                Vec3 d = pw - S.camera.pos;
-                float x_cam = dot(d, right);
-                float y_cam = dot(d, up);
-                float z_cam = dot(d, fwd);
-
-                if (z_cam <= 1e-3f) return false;
-
-                float f = proj.f;
-                float x = (x_cam * f / z_cam) * (proj.scale / f) + proj.cx;
-                float y = (y_cam * f / z_cam) * (proj.scale / f) + proj.cy;
-
-                X = (int)std::lround(x);
-                Y = (int)std::lround(y);
-                depth = z_cam;
-                return true;
-            }
-
-            float denom = proj.f + pw.z;
-            if (denom <= 1e-3f) return false;
-
-            float x = (pw.x * proj.f / denom) * (proj.scale / proj.f) + proj.cx;
-            float y = (pw.y * proj.f / denom) * (proj.scale / proj.f) + proj.cy;
+        int n = static_cast<int>(gen.size());
+        int m = subdivisions;
+        int ax = (axis == 'X' || axis == 'x') ? 0 : (axis == 'Y' || axis == 'y') ? 1 : 2;
 
-            X = (int)std::lround(x);
-            Y = (int)std::lround(y);
-            depth = pw.z + proj.f;
-            return true;
+        vector<float> cosT(m), sinT(m);
+        for (int k = 0; k < m; ++k) {
+            float rad = deg2rad(360.0f * static_cast<float>(k) / static_cast<float>(m));
+            cosT[k] = std::cos(rad);
+            sinT[k] = std::sin(rad);
         }
 
-        Vec3 q = proj.axo(pw);
-        float x = q.x * proj.scale + proj.cx;
-        float y = q.y * proj.scale + proj.cy;
-        X = (int)std::lround(x);
-        Y = (int)std::lround(y);
-        depth = q.z;
-        return true;
-    }
-
-    static void drawMeshZBuffer(const Mesh& mesh, const Mat4& model, const AppState& S,
-        ZBuffer& zBuffer, ImU32 color, bool showWireframe) {
+        float extent = 0.f;
+        for (const Vec3& p : gen) extent = std::max({ extent, std::fabs(p.x), std::fabs(p.y), std::fabs(p.z) });
+        float eps = std::max(1e-6f, extent * 1e-5f);
 
-        Vec3 viewDir{ 0,0,1 };
-        if (S.useCustomView) {
-            viewDir = norm(S.viewVec);
-        }
-        else if (S.proj.perspective && !S.useCamera) {
-            viewDir = { 0, 0, 1 };
+        vector<char> onAxis(n);
+        vector<int> ringStart(n + 1, 0);
+        for (int i = 0; i < n; ++i) {
+            const Vec3& p = gen[i];
+            float r = ax == 0 ? std::hypot(p.y, p.z) : ax == 1 ? std::hypot(p.x, p.z) : std::hypot(p.x, p.y);
+            onAxis[i] = r < eps;
+            ringStart[i + 1] = ringStart[i] + (onAxis[i] ? 1 : m);
         }
-        else if (!S.proj.perspective) {
-            Vec4 v{ 0.f, 0.f, 1.f, 0.f };
-            Mat4 R = Mat4::Rx(S.proj.ax) * Mat4::Ry(S.proj.ay);
-            Vec4 r = v * R;
-            viewDir = norm(Vec3{ r.x, r.y, r.z });
+        vector<int> bandStart(n, 0);
+        for (int i = 0; i + 1 < n; ++i) {
+            bandStart[i + 1] = bandStart[i] + ((onAxis[i] && onAxis[i + 1]) ? 0 : m);
         }
 
-        Vec3 meshC_object = centroid(mesh);
-        Vec3 meshC = xform(meshC_object, model);
-        const float EPS = 1e-6f;
-
-        for (size_t fi = 0; fi < mesh.F.size(); ++fi) {
-            const auto& face = mesh.F[fi];
-            if (face.idx.size() < 3) continue;
-
-            Vec3 normal = computeFaceNormal(mesh, face, model);
-
-            Vec3 fc{ 0,0,0 };
-            for (int vidx : face.idx) {
-                Vec3 v = xform({ mesh.V[vidx].x, mesh.V[vidx].y, mesh.V[vidx].z }, model);
-                fc.x += v.x; fc.y += v.y; fc.z += v.z;
-            }
-            fc = fc * (1.f / (float)face.idx.size());
-
-            Vec3 faceV = fc - meshC;
-            if (dot(normal, faceV) < 0.f) {
-                normal = normal * -1.f;
-            }
-
-            Vec3 finalViewDir = viewDir;
-            if (S.useCamera) {
-                finalViewDir = norm(S.camera.pos - fc);
-            }
-            else if (S.proj.perspective && !S.useCustomView) {
-                Vec3 cam{ 0.f, 0.f, -S.proj.f };
-                finalViewDir = norm(cam - fc);
-            }
-
-            bool frontFacing = dot(normal, finalViewDir) > EPS;
-            if (S.backfaceCull && !frontFacing) {
-                continue;
-            }
-
-            if (face.idx.size() == 3) {
-                std::vector<Vec3> screenCoords;
-                std::vector<float> depths;
-                bool allVisible = true;
-
-                for (int vi : face.idx) {
-                    Vec3 worldPos = xform({ mesh.V[vi].x, mesh.V[vi].y, mesh.V[vi].z }, model);
-                    int sx, sy;
-                    float depth;
-                    if (!projectPointWithCamera(S, worldPos, sx, sy, depth)) {
-                        allVisible = false;
-                        break;
-                    }
-                    screenCoords.push_back({ (float)sx, (float)sy, 0 });
-                    depths.push_back(depth);
-                }
-
-                if (allVisible && screenCoords.size() == 3) {
-                    rasterizeTriangle(zBuffer, screenCoords, depths, color, S);
-
-                    if (showWireframe) {
-                        ImDrawList* dl = ImGui::GetBackgroundDrawList();
-                        for (size_t i = 0; i < 3; ++i) {
-                            size_t next = (i + 1) % 3;
-                            dl->AddLine(
-                                ImVec2(screenCoords[i].x, screenCoords[i].y),
-                                ImVec2(screenCoords[next].x, screenCoords[next].y),
-                                IM_COL32(0, 0, 0, 255), 1.0f
-                            );
-                        }
-                    }
-                }
-            }
-            else {
-                for (size_t i = 1; i < face.idx.size() - 1; ++i) {
-                    std::vector<int> triIndices = { face.idx[0], face.idx[i], face.idx[i + 1] };
-                    std::vector<Vec3> screenCoords;
-                    std::vector<float> depths;
-                    bool allVisible = true;
-
-                    for (int vi : triIndices) {
-                        Vec3 worldPos = xform({ mesh.V[vi].x, mesh.V[vi].y, mesh.V[vi].z }, model);
-                        int sx, sy;
-                        float depth;
-                        if (!projectPointWithCamera(S, worldPos, sx, sy, depth)) {
-                            allVisible = false;
-                            break;
-                        }
-                        screenCoords.push_back({ (float)sx, (float)sy, 0 });
-                        depths.push_back(depth);
-                    }
-
-                    if (allVisible && screenCoords.size() == 3) {
-                        rasterizeTriangle(zBuffer, screenCoords, depths, color, S);
-                    }
+        mesh.V.resize(ringStart[n]);
+        mesh.F.resize(bandStart[n - 1]);
+        auto vid = [&](int i, int k) { return onAxis[i] ? ringStart[i] : ringStart[i] + k; };
+
+        parallelFor(0, m, [&](int k0, int k1) {
+            for (int k = k0; k < k1; ++k) {
+                float c = cosT[k], s = sinT[k];
+                for (int i = 0; i < n; ++i) {
+                    if (onAxis[i] && k != 0) continue;
+                    const Vec3& p = gen[i];
+                    Vertex& v = mesh.V[vid(i, k)];
+                    if (ax == 0) v = { p.x, p.y * c - p.z * s, p.y * s + p.z * c };
+                    else if (ax == 1) v = { p.x * c + p.z * s, p.y, -p.x * s + p.z * c };
+                    else v = { p.x * c - p.y * s, p.x * s + p.y * c, p.z };
                 }
-
-                if (showWireframe) {
-                    drawWireImGui(mesh, model, S, IM_COL32(0, 0, 0, 255), 1.0f);
-                }
-            }
-
-            if (S.showFaceNormals) {
-                Vec3 nstart = fc;
-                Vec3 nend = fc + normal * 30.f;
-                int xs, ys, xe, ye;
-                float depth;
-                if (projectPointWithCamera(S, nstart, xs, ys, depth) &&
-                    projectPointWithCamera(S, nend, xe, ye, depth)) {
-                    ImDrawList* dl = ImGui::GetBackgroundDrawList();
-                    dl->AddLine(ImVec2((float)xs, (float)ys), ImVec2((float)xe, (float)ye),
-                        IM_COL32(200, 30, 30, 255), 1.2f);
+                int kNext = (k + 1) % m;
+                for (int i = 0; i + 1 < n; ++i) {
+                    if (onAxis[i] && onAxis[i + 1]) continue;
+                    int v0 = vid(i, k), v1 = vid(i + 1, k), v2 = vid(i + 1, kNext), v3 = vid(i, kNext);
+                    Face& f = mesh.F[bandStart[i] + k];
+                    if (onAxis[i]) f.idx = { v0, v1, v2 };
+                    else if (onAxis[i + 1]) f.idx = { v0, v1, v3 };
+                    else f.idx = { v0, v1, v2, v3 };
                 }
             }
-        }
-    }
+        }, 256);
 
-#endif
-
-    static Mesh buildRevolution(const vector<Vec3>& gen, char axis, int subdivisions) {
-        Mesh mesh;
-        if (gen.size() < 2 || subdivisions < 3) {
-            return mesh;
-        }
-        int n = static_cast<int>(gen.size());
-        int m = subdivisions;
-        mesh.V.reserve(n * m);
-        float stepDeg = 360.0f / static_cast<float>(m);
-        for (int i = 0; i < n; ++i) {
-            const Vec3& p = gen[i];
-            for (int k = 0; k < m; ++k) {
-                float angle = stepDeg * static_cast<float>(k);
-                float rad = deg2rad(angle);
-                Vec3 rotated;
-                if (axis == 'X' || axis == 'x') {
-                    float c = std::cos(rad);
-                    float s = std::sin(rad);
-                    rotated.x = p.x;
-                    rotated.y = p.y * c - p.z * s;
-                    rotated.z = p.y * s + p.z * c;
-                }
-                else if (axis == 'Y' || axis == 'y') {
-                    float c = std::cos(rad);
-                    float s = std::sin(rad);
-                    rotated.x = p.x * c + p.z * s;
-                    rotated.y = p.y;
-                    rotated.z = -p.x * s + p.z * c;
-                }
-                else {
-                    float c = std::cos(rad);
-                    float s = std::sin(rad);
-                    rotated.x = p.x * c - p.y * s;
-                    rotated.y = p.x * s + p.y * c;
-                    rotated.z = p.z;
-                }
-                mesh.V.push_back({ rotated.x, rotated.y, rotated.z });
-            }
-        }
-        for (int i = 0; i < n - 1; ++i) {
-            for (int k = 0; k < m; ++k) {
-                int kNext = (k + 1) % m;
-                int v0 = i * m + k;
-                int v1 = (i + 1) * m + k;
-                int v2 = (i + 1) * m + kNext;
-                int v3 = i * m + kNext;
-                Face f;
-                f.idx = { v0, v1, v2, v3 };
-                mesh.F.push_back(std::move(f));
-            }
-        }
+        updateBounds(mesh);
         return mesh;
     }
 
@@ -361,7 +116,29 @@ namespace lab7 {
         return 200.0f * std::exp(-(x * x + y * y) / 10000.0f);
     }
 
-    static Mesh buildFunctionSurface(std::function<float(float, float)> func,
+    // Samples func on a (subdivisionsX + 1) x (subdivisionsY + 1) grid, rows in parallel.
+    template <class Func>
+    static vector<Vertex> sampleFunctionGrid(const Func& func, float x0, float x1, float y0, float y1,
+        int subdivisionsX, int subdivisionsY) {
+        vector<Vertex> grid(static_cast<size_t>(subdivisionsX + 1) * (subdivisionsY + 1));
+        float stepX = (x1 - x0) / subdivisionsX;
+        float stepY = (y1 - y0) / subdivisionsY;
+        int pointsPerRow = subdivisionsX + 1;
+        parallelFor(0, subdivisionsY + 1, [&](int r0, int r1) {
+            for (int i = r0; i < r1; ++i) {
+                float y = y0 + i * stepY;
+                Vertex* row = grid.data() + static_cast<size_t>(i) * pointsPerRow;
+                for (int j = 0; j <= subdivisionsX; ++j) {
+                    float x = x0 + j * stepX;
+                    row[j] = { x, y, func(x, y) };
+                }
+            }
+        }, 16);
+        return grid;
+    }
+
+    template <class Func>
+    static Mesh buildFunctionSurface(const Func& func,
         float x0, float x1, float y0, float y1,
         int subdivisionsX, int subdivisionsY) {
         Mesh mesh;
@@ -370,35 +147,147 @@ namespace lab7 {
             return mesh;
         }
 
-        float stepX = (x1 - x0) / subdivisionsX;
-        float stepY = (y1 - y0) / subdivisionsY;
+        mesh.V = sampleFunctionGrid(func, x0, x1, y0, y1, subdivisionsX, subdivisionsY);
 
-        for (int i = 0; i <= subdivisionsY; ++i) {
-            float y = y0 + i * stepY;
-            for (int j = 0; j <= subdivisionsX; ++j) {
-                float x = x0 + j * stepX;
-                float z = func(x, y);
-                mesh.V.push_back({ x, y, z });
+        int pointsPerRow = subdivisionsX + 1;
+        mesh.F.resize(static_cast<size_t>(subdivisionsX) * subdivisionsY);
+        parallelFor(0, subdivisionsY, [&](int r0, int r1) {
+            for (int i = r0; i < r1; ++i) {
+                for (int j = 0; j < subdivisionsX; ++j) {
+                    int v0 = i * pointsPerRow + j;
+                    int v1 = i * pointsPerRow + (j + 1);
+                    int v2 = (i + 1) * pointsPerRow + (j + 1);
+                    int v3 = (i + 1) * pointsPerRow + j;
+                    mesh.F[static_cast<size_t>(i) * subdivisionsX + j].idx = { v0, v1, v2, v3 };
+                }
             }
+        }, 16);
+
+        updateBounds(mesh);
+        return mesh;
+    }
+
+    // Adaptive tessellation of the same sample grid: a rectangle of grid cells is kept as one
+    // patch while every sample inside it lies within maxError of the bilinear patch through its
+    // corners, otherwise it is halved along the longer side. Patches whose edges carry corners of
+    // finer neighbours are fanned from their centre so the surface has no T-junction cracks.
+    template <class Func>
+    static Mesh buildFunctionSurfaceAdaptive(const Func& func,
+        float x0, float x1, float y0, float y1,
+        int subdivisionsX, int subdivisionsY, float maxError) {
+        Mesh mesh;
+
+        if (subdivisionsX < 1 || subdivisionsY < 1) {
+            return mesh;
         }
 
+        vector<Vertex> grid = sampleFunctionGrid(func, x0, x1, y0, y1, subdivisionsX, subdivisionsY);
         int pointsPerRow = subdivisionsX + 1;
-        for (int i = 0; i < subdivisionsY; ++i) {
-            for (int j = 0; j < subdivisionsX; ++j) {
-                int v0 = i * pointsPerRow + j;
-                int v1 = i * pointsPerRow + (j + 1);
-                int v2 = (i + 1) * pointsPerRow + (j + 1);
-                int v3 = (i + 1) * pointsPerRow + j;
+        auto at = [&](int i, int j) -> const Vertex& { return grid[static_cast<size_t>(i) * pointsPerRow + j]; };
+
+        struct Patch { int i0, j0, i1, j1; };
+        auto flatEnough = [&](const Patch& p) {
+            float z00 = at(p.i0, p.j0).z, z01 = at(p.i0, p.j1).z;
+            float z10 = at(p.i1, p.j0).z, z11 = at(p.i1, p.j1).z;
+            float invH = 1.f / (p.i1 - p.i0), invW = 1.f / (p.j1 - p.j0);
+            for (int i = p.i0; i <= p.i1; ++i) {
+                float v = (i - p.i0) * invH;
+                float zl = z00 + (z10 - z00) * v, zr = z01 + (z11 - z01) * v;
+                for (int j = p.j0; j <= p.j1; ++j) {
+                    float u = (j - p.j0) * invW;
+                    if (std::fabs(at(i, j).z - (zl + (zr - zl) * u)) > maxError) return false;
+                }
+            }
+            return true;
+        };
+
+        vector<Patch> leaves;
+        vector<Patch> stack = { { 0, 0, subdivisionsY, subdivisionsX } };
+        while (!stack.empty()) {
+            Patch p = stack.back();
+            stack.pop_back();
+            int h = p.i1 - p.i0, w = p.j1 - p.j0;
+            if ((h == 1 && w == 1) || flatEnough(p)) {
+                leaves.push_back(p);
+            }
+            else if (w >= h) {
+                int jm = p.j0 + w / 2;
+                stack.push_back({ p.i0, p.j0, p.i1, jm });
+                stack.push_back({ p.i0, jm, p.i1, p.j1 });
+            }
+            else {
+                int im = p.i0 + h / 2;
+                stack.push_back({ p.i0, p.j0, im, p.j1 });
+                stack.push_back({ im, p.j0, p.i1, p.j1 });
+            }
+        }
+
+        vector<int> remap(grid.size(), -1);
+        for (const Patch& p : leaves) {
+            remap[static_cast<size_t>(p.i0) * pointsPerRow + p.j0] = 0;
+            remap[static_cast<size_t>(p.i0) * pointsPerRow + p.j1] = 0;
+            remap[static_cast<size_t>(p.i1) * pointsPerRow + p.j0] = 0;
+            remap[static_cast<size_t>(p.i1) * pointsPerRow + p.j1] = 0;
+        }
+        for (size_t k = 0; k < grid.size(); ++k) {
+            if (remap[k] < 0) continue;
+            remap[k] = static_cast<int>(mesh.V.size());
+            mesh.V.push_back(grid[k]);
+        }
+
+        float stepX = (x1 - x0) / subdivisionsX;
+        float stepY = (y1 - y0) / subdivisionsY;
+        vector<int> ring;
+        for (const Patch& p : leaves) {
+            ring.clear();
+            auto take = [&](int i, int j) {
+                int v = remap[static_cast<size_t>(i) * pointsPerRow + j];
+                if (v >= 0) ring.push_back(v);
+            };
+            for (int j = p.j0; j < p.j1; ++j) take(p.i0, j);
+            for (int i = p.i0; i < p.i1; ++i) take(i, p.j1);
+            for (int j = p.j1; j > p.j0; --j) take(p.i1, j);
+            for (int i = p.i1; i > p.i0; --i) take(i, p.j0);
 
+            if (ring.size() == 4) {
+                Face f;
+                f.idx = ring;
+                mesh.F.push_back(std::move(f));
+                continue;
+            }
+            float xc = x0 + 0.5f * (p.j0 + p.j1) * stepX;
+            float yc = y0 + 0.5f * (p.i0 + p.i1) * stepY;
+            int c = static_cast<int>(mesh.V.size());
+            mesh.V.push_back({ xc, yc, func(xc, yc) });
+            for (size_t k = 0; k < ring.size(); ++k) {
                 Face f;
-                f.idx = { v0, v1, v2, v3 };
+                f.idx = { c, ring[k], ring[(k + 1) % ring.size()] };
                 mesh.F.push_back(std::move(f));
             }
         }
 
+        updateBounds(mesh);
         return mesh;
     }
 
+    // Calls body with the selected demo function as a distinct lambda type, so the surface
+    // builders get a callable they can inline instead of a std::function.
+    template <class Body>
+    static auto withSurfaceFunction(int funcIndex, Body&& body) {
+        switch (funcIndex) {
+        case 1:
+            return body([](float x, float y) { return funcParaboloid(x, y); });
+        case 2:
+            return body([](float x, float y) { return funcSaddle(x, y); });
+        case 3:
+            return body([](float x, float y) { return funcWave(x, y); });
+        case 4:
+            return body([](float x, float y) { return funcHill(x, y); });
+        default:
+            return body([](float x, float y) { return funcPlane(x, y); });
+        }
+    }
+
     static vector<pair<Mesh, Mat4>> createDemoObjects(const AppState& S) {
         vector<pair<Mesh, Mat4>> objects;
 
@@ -485,6 +374,8 @@ namespace lab7 {
         static float x0 = -200.0f, x1 = 200.0f;
         static float y0 = -200.0f, y1 = 200.0f;
         static int subdivX = 20, subdivY = 20;
+        static bool adaptiveSurface = false;
+        static float surfaceMaxError = 0.5f;
 
         static float translateX = 0.f, translateY = 0.f, translateZ = 0.f;
         static float rotateX = 0.f, rotateY = 0.f, rotateZ = 0.f;
@@ -495,6 +386,7 @@ namespace lab7 {
 
         while (!glfwWindowShouldClose(win)) {
             glfwPollEvents();
+            FrameProfiler::instance().beginFrame();
             applyKeyOps(win, S);
 
             if (autoRotateCamera && S.useCamera && S.cameraOrbit) {
@@ -606,6 +498,8 @@ namespace lab7 {
                 }
             }
 
+            drawCullStats(S);
+
             ImGui::SeparatorText("Lighting");
             const char* shadingItems[] = { "Wireframe", "Gouraud (Lambert)", "Phong toon", "Textured" };
             ImGui::Combo("Shading", &S.shadingMode, shadingItems, IM_ARRAYSIZE(shadingItems));
@@ -716,7 +610,7 @@ namespace lab7 {
             }
             if (ImGui::Button("Build revolution")) {
                 char axisChar = axisNames[axisIndex][0];
-                Mesh newMesh = buildRevolution(generatrix, axisChar, subdivisions);
+                Mesh newMesh = buildRevolutionWelded(generatrix, axisChar, subdivisions);
                 if (!newMesh.V.empty()) {
                     S.kind = PolyKind::UserObj;
                     S.base = newMesh;
@@ -740,42 +634,33 @@ namespace lab7 {
             if (subdivX < 1) subdivX = 1;
             if (subdivY < 1) subdivY = 1;
 
-            if (ImGui::Button("Build Function Surface")) {
-                std::function<float(float, float)> selectedFunc;
-
-                switch (funcIndex) {
-                case 0:
-                    selectedFunc = funcPlane;
-                    break;
-                case 1:
-                    selectedFunc = funcParaboloid;
-                    break;
-                case 2:
-                    selectedFunc = funcSaddle;
-                    break;
-                case 3:
-                    selectedFunc = funcWave;
-                    break;
-                case 4:
-                    selectedFunc = funcHill;
-                    break;
-                default:
-                    selectedFunc = funcPlane;
-                }
+            ImGui::Checkbox("Adaptive", &adaptiveSurface);
+            if (adaptiveSurface) {
+                ImGui::InputFloat("Max error", &surfaceMaxError);
+                if (surfaceMaxError < 0.f) surfaceMaxError = 0.f;
+            }
 
-                Mesh newMesh = buildFunctionSurface(selectedFunc, x0, x1, y0, y1, subdivX, subdivY);
+            if (ImGui::Button("Build Function Surface")) {
+                Mesh newMesh = withSurfaceFunction(funcIndex, [&](const auto& func) {
+                    if (adaptiveSurface) {
+                        return buildFunctionSurfaceAdaptive(func, x0, x1, y0, y1, subdivX, subdivY, surfaceMaxError);
+                    }
+                    return buildFunctionSurface(func, x0, x1, y0, y1, subdivX, subdivY);
+                });
                 if (!newMesh.V.empty()) {
                     S.kind = PolyKind::UserObj;
                     S.base = newMesh;
                     S.modelMat = Mat4::I();
                     string objName = string("Func@") + funcNames[funcIndex] +
-                        string("/") + std::to_string(subdivX) + "x" + std::to_string(subdivY);
+                        string("/") + std::to_string(subdivX) + "x" + std::to_string(subdivY) +
+                        (adaptiveSurface ? string("/adaptive") : string());
                     S.meshesNames.push_back(objName);
                     S.meshes.push_back({ PolyKind::UserObj, newMesh });
                     S.polyIdx = static_cast<int>(S.meshes.size() - 1);
                 }
             }
             ImGui::End();
+            FrameProfiler::instance().drawOverlay();
 
             saveFileDialog.Display();
             if (saveFileDialog.HasSelected()) {
@@ -802,10 +687,12 @@ namespace lab7 {
             S.proj.cy = displaySize.y * 0.5f;
 
             if (useZBuffer) {
+                ScopedTimer clearTimer(ProfStage::Raster);
                 zBuffer.clear();
             }
 
             if (showAxes) drawAxes(S, 250.f);
+            S.cullStats = {};
 
             vector<pair<Mesh, Mat4>> demoObjects = createDemoObjects(S);
             vector<ImU32> demoColors = {
@@ -856,11 +743,14 @@ namespace lab7 {
 
             int fbw, fbh;
             glfwGetFramebufferSize(win, &fbw, &fbh);
+            ScopedTimer submitTimer(ProfStage::Submit);
             ImGui::Render();
             glViewport(0, 0, fbw, fbh);
             glClearColor(0.96f, 0.96f, 0.96f, 1.f);
             glClear(GL_COLOR_BUFFER_BIT);
             ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            submitTimer.stop();
+            FrameProfiler::instance().endFrame();
             glfwSwapBuffers(win);
         }
         ImGui_ImplOpenGL3_Shutdown();
@@ -0,0 +1,307 @@
+#ifndef CS332_ZBUFFER_H
+#define CS332_ZBUFFER_H
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <imgui.h>
+#include "../lab06/lab.h"
+
+namespace lab7 {
+
+    static constexpr float INF = std::numeric_limits<float>::max();
+
+    struct ZBuffer {
+        int width, height;
+        std::vector<float> buffer;
+
+        ZBuffer(int w, int h) : width(w), height(h), buffer(w* h, INF) {}
+
+        void clear() {
+            std::fill(buffer.begin(), buffer.end(), INF);
+        }
+
+        bool testAndSet(int x, int y, float z) {
+            if (x < 0 || x >= width || y < 0 || y >= height) return false;
+            int idx = y * width + x;
+            if (z < buffer[idx]) {
+                buffer[idx] = z;
+                return true;
+            }
+            return false;
+        }
+    };
+
+    inline Vec3 computeFaceNormal(const Mesh& mesh, const Face& face, const Mat4& model) {
+        if (face.idx.size() < 3) return { 0, 0, 0 };
+
+        Vec3 v0 = xform({ mesh.V[face.idx[0]].x, mesh.V[face.idx[0]].y, mesh.V[face.idx[0]].z }, model);
+        Vec3 v1 = xform({ mesh.V[face.idx[1]].x, mesh.V[face.idx[1]].y, mesh.V[face.idx[1]].z }, model);
+        Vec3 v2 = xform({ mesh.V[face.idx[2]].x, mesh.V[face.idx[2]].y, mesh.V[face.idx[2]].z }, model);
+
+        Vec3 edge1 = v1 - v0;
+        Vec3 edge2 = v2 - v0;
+        return norm(cross(edge1, edge2));
+    }
+
+    inline bool isFaceVisible(const Vec3& normal, const Vec3& viewDir) {
+        return dot(normal, viewDir) < 0;
+    }
+
+    static void rasterizeTriangle(RenderTarget& rt, ZBuffer& zBuffer, const std::vector<Vec3>& screenCoords,
+        const std::vector<float>& depths, ImU32 color, const AppState& S) {
+        int minX = S.proj.cx * 2, maxX = 0;
+        int minY = S.proj.cy * 2, maxY = 0;
+
+        for (const auto& p : screenCoords) {
+            minX = std::min(minX, (int)p.x);
+            maxX = std::max(maxX, (int)p.x);
+            minY = std::min(minY, (int)p.y);
+            maxY = std::max(maxY, (int)p.y);
+        }
+
+        minX = std::max(0, minX);
+        maxX = std::min(zBuffer.width - 1, maxX);
+        minY = std::max(0, minY);
+        maxY = std::min(zBuffer.height - 1, maxY);
+
+        const Vec3& v0 = screenCoords[0];
+        const Vec3& v1 = screenCoords[1];
+        const Vec3& v2 = screenCoords[2];
+
+        float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+        if (std::abs(area) < 1e-6f) return;
+
+        float invArea = 1.0f / area;
+
+        int64_t shaded = 0, rejected = 0;
+
+        for (int y = minY; y <= maxY; ++y) {
+            for (int x = minX; x <= maxX; ++x) {
+                float w0 = ((v1.x - x) * (v2.y - y) - (v2.x - x) * (v1.y - y)) * invArea;
+                float w1 = ((v2.x - x) * (v0.y - y) - (v0.x - x) * (v2.y - y)) * invArea;
+                float w2 = ((v0.x - x) * (v1.y - y) - (v1.x - x) * (v0.y - y)) * invArea;
+
+                if (w0 >= 0 && w1 >= 0 && w2 >= 0) {
+                    float z = w0 * depths[0] + w1 * depths[1] + w2 * depths[2];
+
+                    if (zBuffer.testAndSet(x, y, z)) {
+                        rt.pixel(x, y, color);
+                        shaded++;
+                    }
+                    else {
+                        rejected++;
+                    }
+                }
+            }
+        }
+        frameCounters().fragmentsShaded += shaded;
+        frameCounters().depthRejected += rejected;
+    }
+
+    static bool projectPointWithCamera(const AppState& S, const Vec3& pw, int& X, int& Y, float& depth) {
+        const Projector& proj = S.proj;
+
+        if (proj.perspective) {
+            if (S.useCamera) {
+                Vec3 fwd = norm(S.camera.target - S.camera.pos);
+                if (vlen(fwd) < 1e-6f) return false;
+
+                Vec3 up = S.camera.up;
+                if (vlen(up) < 1e-6f) up = { 0.f, 1.f, 0.f };
+
+                Vec3 right = norm(cross(fwd, up));
+                if (vlen(right) < 1e-6f) {
+                    up = { 0.f, 1.f, 0.f };
+                    right = norm(cross(fwd, up));
+                }
+                up = cross(right, fwd);
+
+                Vec3 d = pw - S.camera.pos;
+                float x_cam = dot(d, right);
+                float y_cam = dot(d, up);
+                float z_cam = dot(d, fwd);
+
+                if (z_cam <= 1e-3f) return false;
+
+                float f = proj.f;
+                float x = (x_cam * f / z_cam) * (proj.scale / f) + proj.cx;
+                float y = (y_cam * f / z_cam) * (proj.scale / f) + proj.cy;
+
+                X = (int)std::lround(x);
+                Y = (int)std::lround(y);
+                depth = z_cam;
+                return true;
+            }
+
+            float denom = proj.f + pw.z;
+            if (denom <= 1e-3f) return false;
+
+            float x = (pw.x * proj.f / denom) * (proj.scale / proj.f) + proj.cx;
+            float y = (pw.y * proj.f / denom) * (proj.scale / proj.f) + proj.cy;
+
+            X = (int)std::lround(x);
+            Y = (int)std::lround(y);
+            depth = pw.z + proj.f;
+            return true;
+        }
+
+        Vec3 q = proj.axo(pw);
+        float x = q.x * proj.scale + proj.cx;
+        float y = q.y * proj.scale + proj.cy;
+        X = (int)std::lround(x);
+        Y = (int)std::lround(y);
+        depth = q.z;
+        return true;
+    }
+
+    static void drawMeshZBuffer(RenderTarget& rt, const Mesh& mesh, const Mat4& model, const AppState& S,
+        ZBuffer& zBuffer, ImU32 color, bool showWireframe) {
+
+        Vec3 viewDir{ 0,0,1 };
+        if (S.useCustomView) {
+            viewDir = norm(S.viewVec);
+        }
+        else if (S.proj.perspective && !S.useCamera) {
+            viewDir = { 0, 0, 1 };
+        }
+        else if (!S.proj.perspective) {
+            Vec4 v{ 0.f, 0.f, 1.f, 0.f };
+            Mat4 R = Mat4::Rx(S.proj.ax) * Mat4::Ry(S.proj.ay);
+            Vec4 r = v * R;
+            viewDir = norm(Vec3{ r.x, r.y, r.z });
+        }
+
+        std::vector<char> clusterVisible;
+        if (!cullMesh(mesh, model, S, clusterVisible)) return;
+
+        // Back-face and projection tests are booked as cull; the surviving triangles are then
+        // rasterized in one timed batch, in the original face order.
+        ScopedTimer cullTimer(ProfStage::Cull);
+        struct ZTriangle {
+            std::vector<Vec3> screenCoords;
+            std::vector<float> depths;
+        };
+        struct ZFace {
+            Vec3 fc, normal;
+            size_t firstTriangle, triangleCount;
+            bool wireEdges;
+        };
+        std::vector<ZTriangle> triangles;
+        std::vector<ZFace> faces;
+
+        Vec3 meshC_object = centroid(mesh);
+        Vec3 meshC = xform(meshC_object, model);
+        const float EPS = 1e-6f;
+        bool wirePolygons = false;
+
+        for (size_t fi = 0; fi < mesh.F.size(); ++fi) {
+            const auto& face = mesh.F[fi];
+            if (face.idx.size() < 3 || !faceVisible(clusterVisible, fi)) continue;
+
+            Vec3 normal = computeFaceNormal(mesh, face, model);
+
+            Vec3 fc{ 0,0,0 };
+            for (int vidx : face.idx) {
+                Vec3 v = xform({ mesh.V[vidx].x, mesh.V[vidx].y, mesh.V[vidx].z }, model);
+                fc.x += v.x; fc.y += v.y; fc.z += v.z;
+            }
+            fc = fc * (1.f / (float)face.idx.size());
+
+            Vec3 faceV = fc - meshC;
+            if (dot(normal, faceV) < 0.f) {
+                normal = normal * -1.f;
+            }
+
+            Vec3 finalViewDir = viewDir;
+            if (S.useCamera) {
+                finalViewDir = norm(S.camera.pos - fc);
+            }
+            else if (S.proj.perspective && !S.useCustomView) {
+                Vec3 cam{ 0.f, 0.f, -S.proj.f };
+                finalViewDir = norm(cam - fc);
+            }
+
+            bool frontFacing = dot(normal, finalViewDir) > EPS;
+            if (S.backfaceCull && !frontFacing) {
+                frameCounters().trianglesCulled += (int)face.idx.size() - 2;
+                continue;
+            }
+
+            ZFace zf{ fc, normal, triangles.size(), 0, showWireframe && face.idx.size() == 3 };
+            for (size_t i = 1; i + 1 < face.idx.size(); ++i) {
+                int triIndices[3] = { face.idx[0], face.idx[i], face.idx[i + 1] };
+                ZTriangle tri;
+                bool allVisible = true;
+
+                for (int vi : triIndices) {
+                    Vec3 worldPos = xform({ mesh.V[vi].x, mesh.V[vi].y, mesh.V[vi].z }, model);
+                    int sx, sy;
+                    float depth;
+                    if (!projectPointWithCamera(S, worldPos, sx, sy, depth)) {
+                        allVisible = false;
+                        break;
+                    }
+                    tri.screenCoords.push_back({ (float)sx, (float)sy, 0 });
+                    tri.depths.push_back(depth);
+                }
+
+                if (allVisible) {
+                    triangles.push_back(std::move(tri));
+                    zf.triangleCount++;
+                }
+                else {
+                    frameCounters().trianglesCulled++;
+                }
+            }
+            if (face.idx.size() > 3) {
+                wirePolygons = true;
+            }
+            faces.push_back(zf);
+        }
+        cullTimer.stop();
+
+        ScopedTimer rasterTimer(ProfStage::Raster);
+        frameCounters().trianglesRasterized += (int64_t)triangles.size();
+        for (const ZFace& zf : faces) {
+            for (size_t t = zf.firstTriangle; t < zf.firstTriangle + zf.triangleCount; ++t) {
+                ZTriangle& tri = triangles[t];
+                rasterizeTriangle(rt, zBuffer, tri.screenCoords, tri.depths, color, S);
+
+                if (zf.wireEdges) {
+                    for (size_t i = 0; i < 3; ++i) {
+                        size_t next = (i + 1) % 3;
+                        rt.line(tri.screenCoords[i].x, tri.screenCoords[i].y,
+                            tri.screenCoords[next].x, tri.screenCoords[next].y,
+                            IM_COL32(0, 0, 0, 255), 1.0f);
+                    }
+                }
+            }
+
+            if (S.showFaceNormals) {
+                Vec3 nstart = zf.fc;
+                Vec3 nend = zf.fc + zf.normal * 30.f;
+                int xs, ys, xe, ye;
+                float depth;
+                if (projectPointWithCamera(S, nstart, xs, ys, depth) &&
+                    projectPointWithCamera(S, nend, xe, ye, depth)) {
+                    rt.line((float)xs, (float)ys, (float)xe, (float)ye, IM_COL32(200, 30, 30, 255), 1.2f);
+                }
+            }
+        }
+        rasterTimer.stop();
+
+        if (showWireframe && wirePolygons) {
+            drawWire(rt, mesh, model, S, clusterVisible, IM_COL32(0, 0, 0, 255), 1.0f, false);
+        }
+    }
+
+    static void drawMeshZBuffer(const Mesh& mesh, const Mat4& model, const AppState& S,
+        ZBuffer& zBuffer, ImU32 color, bool showWireframe) {
+        ImGuiTarget rt;
+        drawMeshZBuffer(rt, mesh, model, S, zBuffer, color, showWireframe);
+    }
+}
+
+#endif //CS332_ZBUFFER_H
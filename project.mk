@@ -26,6 +26,16 @@ help:
 build:
 	g++ -std=c++20 main.cpp lab07/task2.cpp build/imgui/imgui_draw.cpp build/imgui/imgui.cpp build/imgui/imgui_widgets.cpp build/imgui/imgui_tables.cpp build/imgui/backends/imgui_impl_opengl3.cpp build/imgui/backends/imgui_impl_glfw.cpp -framework OpenGL `pkg-config --cflags --libs opencv4 glfw3` -lglfw -Ibuild/imgui -Ibuild/imgui/backends -Ibuild/imfilebrowser
 
+.PHONY: build-bench
+## builds headless software renderer benchmark (render_bench)
+build-bench:
+	g++ -std=c++20 -O2 lab06/bench.cpp build/imgui/imgui_draw.cpp build/imgui/imgui.cpp build/imgui/imgui_widgets.cpp build/imgui/imgui_tables.cpp `pkg-config --cflags --libs glfw3` -I. -Ibuild/imgui -Ibuild/imgui/backends -Ibuild/imfilebrowser -o render_bench
+
+.PHONY: bench
+## runs render_bench on models/duck.obj
+bench: build-bench
+	./render_bench models/duck.obj --frames 120
+
 .PHONY: run
 ## runs project
 run: build